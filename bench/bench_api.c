@@ -0,0 +1,460 @@
+/* Latency of the public API: median and 99th percentile per call
+ *
+ * This file is in the public domain.
+ *
+ * Usage: api.bench [-j] [-c cpu] [-f filter]
+ *
+ *   -j         print JSON, for regression tracking, rather than a table
+ *   -c cpu     pin to the given CPU (the default is the one we start on)
+ *   -f filter  run only the benchmarks whose names contain filter
+ *
+ * Each benchmark is warmed up, then timed in batches of calls, sized so
+ * that the clock overhead is negligible. Statistics are over the per-call
+ * time of each batch. Cycles are TSC ticks, where there is a TSC.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "f25519.h"
+#include "fprime.h"
+#include "c25519.h"
+#include "ed25519.h"
+#include "edsign.h"
+#include "ecdsa.h"
+#include "sc25519.h"
+#include "sha512.h"
+#include "cpu.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+#define WARMUP_NS     50000000.0
+#define BUDGET_NS     250000000.0
+#define BATCH_NS      50000.0
+#define MIN_SAMPLES   21
+#define MAX_SAMPLES   1000
+#define MAX_MESSAGE   (1 << 20)
+
+static const size_t message_sizes[] = {
+	0, 64, 1024, 16384, 65536, MAX_MESSAGE
+};
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long ticks(void)
+{
+#ifdef HAVE_RDTSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/* Operands, shared by all benchmarks */
+static uint8_t fx[F25519_SIZE];
+static uint8_t fy[F25519_SIZE];
+static uint8_t fr[F25519_SIZE];
+static uint8_t exponent[C25519_EXPONENT_SIZE];
+static struct ed25519_pt point;
+
+static uint8_t secret[EDSIGN_SECRET_KEY_SIZE];
+static uint8_t pub[EDSIGN_PUBLIC_KEY_SIZE];
+static uint8_t sig[EDSIGN_SIGNATURE_SIZE];
+static uint8_t *message;
+static size_t message_len;
+
+static uint8_t ecdsa_d[FPRIME_SIZE];
+static uint8_t ecdsa_e[FPRIME_SIZE];
+static uint8_t ecdsa_k[FPRIME_SIZE];
+static uint8_t ecdsa_x[F25519_SIZE];
+static uint8_t ecdsa_y[F25519_SIZE];
+static uint8_t ecdsa_r[FPRIME_SIZE];
+static uint8_t ecdsa_s[FPRIME_SIZE];
+
+/* Each result feeds the next call, so that we measure latency */
+static void run_f25519_mul(void)
+{
+	f25519_mul__distinct(fr, fx, fy);
+	f25519_copy(fx, fr);
+}
+
+static void run_f25519_inv(void)
+{
+	f25519_inv__distinct(fr, fx);
+	f25519_copy(fx, fr);
+}
+
+static void run_f25519_sqrt(void)
+{
+	f25519_sqrt(fr, fx);
+	f25519_copy(fx, fr);
+}
+
+static void run_fprime_mul(void)
+{
+	fprime_mul(fr, fx, fy, sc25519_order);
+	fprime_copy(fx, fr);
+}
+
+static void run_fprime_inv(void)
+{
+	fprime_inv(fr, fx, sc25519_order);
+	fprime_copy(fx, fr);
+}
+
+static void run_c25519_smult(void)
+{
+	c25519_smult(fr, c25519_base_x, exponent);
+}
+
+static void run_ed25519_smult(void)
+{
+	struct ed25519_pt r;
+
+	ed25519_smult(&r, &point, exponent);
+}
+
+static void run_sec_to_pub(void)
+{
+	edsign_sec_to_pub(pub, secret);
+}
+
+static void run_sign(void)
+{
+	edsign_sign(sig, pub, secret, message, message_len);
+}
+
+static void run_verify(void)
+{
+	if (!edsign_verify(sig, pub, message, message_len))
+		abort();
+}
+
+static void run_sha512(void)
+{
+	struct sha512_state s;
+	size_t i;
+
+	sha512_init(&s);
+
+	for (i = 0; i + SHA512_BLOCK_SIZE <= message_len;
+	     i += SHA512_BLOCK_SIZE)
+		sha512_block(&s, message + i);
+
+	sha512_final(&s, message + i, message_len);
+	sha512_get(&s, fr, 0, sizeof(fr));
+}
+
+static void run_ecdsa_sign(void)
+{
+	if (!ecdsa_sign(ecdsa_r, ecdsa_s, ecdsa_d, ecdsa_e, ecdsa_k))
+		abort();
+}
+
+static void run_ecdsa_verify(void)
+{
+	if (!ecdsa_verify(ecdsa_x, ecdsa_y, ecdsa_e, ecdsa_r, ecdsa_s))
+		abort();
+}
+
+struct result {
+	const char		*name;
+	int			sized;
+	size_t			bytes;
+	unsigned int		samples;
+	unsigned long		reps;
+	double			median_ns;
+	double			p99_ns;
+	double			median_cycles;
+	double			p99_cycles;
+};
+
+static int json;
+static const char *filter;
+static unsigned int results;
+
+static int compare_double(const void *a, const void *b)
+{
+	const double x = *(const double *)a;
+	const double y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Value at or below which a fraction p of the sorted samples lie */
+static double percentile(const double *v, unsigned int n, double p)
+{
+	unsigned int i = p * n;
+
+	if (i >= n)
+		i = n - 1;
+
+	return v[i];
+}
+
+static void print_result(const struct result *r)
+{
+	if (json) {
+		printf("%s\n    {\"name\": \"%s\", ", results ? "," : "",
+		       r->name);
+
+		if (r->sized)
+			printf("\"bytes\": %lu, ", (unsigned long)r->bytes);
+		else
+			printf("\"bytes\": null, ");
+
+		printf("\"samples\": %u, \"reps\": %lu, "
+		       "\"median_ns\": %.1f, \"p99_ns\": %.1f, ",
+		       r->samples, r->reps, r->median_ns, r->p99_ns);
+
+#ifdef HAVE_RDTSC
+		printf("\"median_cycles\": %.0f, \"p99_cycles\": %.0f, ",
+		       r->median_cycles, r->p99_cycles);
+#else
+		printf("\"median_cycles\": null, \"p99_cycles\": null, ");
+#endif
+
+		if (r->sized && r->bytes)
+			printf("\"mb_per_s\": %.2f}",
+			       r->bytes * 1e3 / r->median_ns);
+		else
+			printf("\"mb_per_s\": null}");
+	} else {
+		char size[16] = "-";
+		char rate[16] = "-";
+
+		if (r->sized)
+			snprintf(size, sizeof(size), "%lu",
+				 (unsigned long)r->bytes);
+		if (r->sized && r->bytes)
+			snprintf(rate, sizeof(rate), "%.2f",
+				 r->bytes * 1e3 / r->median_ns);
+
+		printf("%-22s %8s %12.1f %12.1f %12.0f %12.0f %10s\n",
+		       r->name, size, r->median_ns, r->p99_ns,
+		       r->median_cycles, r->p99_cycles, rate);
+	}
+
+	fflush(stdout);
+	results++;
+}
+
+static void measure(const char *name, int sized, size_t bytes,
+		    void (*fn)(void))
+{
+	static double ns[MAX_SAMPLES];
+	static double cycles[MAX_SAMPLES];
+	struct result r;
+	unsigned long reps = 1;
+	unsigned long i;
+	double start;
+	double t;
+
+	if (filter && !strstr(name, filter))
+		return;
+
+	/* Warm up (caches, branch predictors, clock frequency), and find
+	 * a batch size long enough to time accurately.
+	 */
+	start = now_ns();
+	do {
+		t = now_ns();
+		for (i = 0; i < reps; i++)
+			fn();
+		t = now_ns() - t;
+
+		if (t < BATCH_NS)
+			reps *= 2;
+	} while (t < BATCH_NS || now_ns() - start < WARMUP_NS);
+
+	r.name = name;
+	r.sized = sized;
+	r.bytes = bytes;
+	r.reps = reps;
+	r.samples = 0;
+
+	start = now_ns();
+	do {
+		const unsigned long long c = ticks();
+
+		t = now_ns();
+		for (i = 0; i < reps; i++)
+			fn();
+		ns[r.samples] = (now_ns() - t) / reps;
+		cycles[r.samples] = (double)(ticks() - c) / reps;
+		r.samples++;
+	} while (r.samples < MAX_SAMPLES &&
+		 (r.samples < MIN_SAMPLES || now_ns() - start < BUDGET_NS));
+
+	qsort(ns, r.samples, sizeof(ns[0]), compare_double);
+	qsort(cycles, r.samples, sizeof(cycles[0]), compare_double);
+
+	r.median_ns = percentile(ns, r.samples, 0.5);
+	r.p99_ns = percentile(ns, r.samples, 0.99);
+	r.median_cycles = percentile(cycles, r.samples, 0.5);
+	r.p99_cycles = percentile(cycles, r.samples, 0.99);
+
+	print_result(&r);
+}
+
+/* Pin to one CPU, so that samples aren't spread over cores running at
+ * different speeds. Returns the CPU, or -1 if pinning isn't supported.
+ */
+static int pin(int cpu)
+{
+#ifdef __linux__
+	cpu_set_t set;
+
+	if (cpu < 0)
+		cpu = sched_getcpu();
+	if (cpu < 0)
+		return -1;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+
+	if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+		perror("sched_setaffinity");
+		exit(1);
+	}
+
+	return cpu;
+#else
+	(void)cpu;
+	return -1;
+#endif
+}
+
+static void randomize(uint8_t *x, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		x[i] = random();
+}
+
+static void print_header(int cpu)
+{
+	const struct cpu_dispatch *d = cpu_dispatch();
+	char features[128];
+
+	cpu_feature_names(features, sizeof(features), d->features);
+
+	if (json) {
+		printf("{\n  \"cpu\": %d,\n  \"features\": \"%s\",\n", cpu,
+		       features);
+		printf("  \"backends\": {\"f25519\": \"%s\", "
+		       "\"ed25519\": \"%s\", \"c25519_x4\": \"%s\"},\n",
+		       d->f25519, d->ed25519, d->c25519_x4);
+		printf("  \"results\": [");
+		return;
+	}
+
+	printf("cpu %d, features: %s\n", cpu, features);
+	printf("backends: f25519 %s, ed25519 %s, c25519_x4 %s\n\n",
+	       d->f25519, d->ed25519, d->c25519_x4);
+	printf("%-22s %8s %12s %12s %12s %12s %10s\n", "function", "bytes",
+	       "median ns", "p99 ns", "median cyc", "p99 cyc", "MB/s");
+}
+
+int main(int argc, char **argv)
+{
+	int cpu = -1;
+	unsigned int i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "jc:f:")) >= 0)
+		switch (opt) {
+		case 'j':
+			json = 1;
+			break;
+
+		case 'c':
+			cpu = atoi(optarg);
+			break;
+
+		case 'f':
+			filter = optarg;
+			break;
+
+		default:
+			fprintf(stderr, "usage: %s [-j] [-c cpu] "
+				"[-f filter]\n", argv[0]);
+			return 1;
+		}
+
+	cpu = pin(cpu);
+
+	message = malloc(MAX_MESSAGE);
+	if (!message) {
+		perror("malloc");
+		return 1;
+	}
+
+	randomize(message, MAX_MESSAGE);
+	randomize(fx, sizeof(fx));
+	randomize(fy, sizeof(fy));
+	randomize(exponent, sizeof(exponent));
+	randomize(secret, sizeof(secret));
+	fx[31] &= 0x7f;
+	fy[31] &= 0x7f;
+	c25519_prepare(exponent);
+	ed25519_smult(&point, &ed25519_base, exponent);
+	edsign_sec_to_pub(pub, secret);
+
+	randomize(ecdsa_d, sizeof(ecdsa_d));
+	randomize(ecdsa_e, sizeof(ecdsa_e));
+	randomize(ecdsa_k, sizeof(ecdsa_k));
+	sc25519_from_bytes(ecdsa_d, ecdsa_d, sizeof(ecdsa_d));
+	sc25519_from_bytes(ecdsa_k, ecdsa_k, sizeof(ecdsa_k));
+	c25519_prepare(ecdsa_e);
+	ecdsa_pubkey(ecdsa_x, ecdsa_y, ecdsa_d);
+	if (!ecdsa_sign(ecdsa_r, ecdsa_s, ecdsa_d, ecdsa_e, ecdsa_k))
+		abort();
+
+	print_header(cpu);
+
+	measure("f25519_mul__distinct", 0, 0, run_f25519_mul);
+	measure("f25519_inv__distinct", 0, 0, run_f25519_inv);
+	measure("f25519_sqrt", 0, 0, run_f25519_sqrt);
+	measure("fprime_mul", 0, 0, run_fprime_mul);
+	measure("fprime_inv", 0, 0, run_fprime_inv);
+	measure("c25519_smult", 0, 0, run_c25519_smult);
+	measure("ed25519_smult", 0, 0, run_ed25519_smult);
+	measure("edsign_sec_to_pub", 0, 0, run_sec_to_pub);
+
+	for (i = 0; i < sizeof(message_sizes) / sizeof(message_sizes[0]);
+	     i++) {
+		message_len = message_sizes[i];
+		edsign_sign(sig, pub, secret, message, message_len);
+
+		measure("edsign_sign", 1, message_len, run_sign);
+		measure("edsign_verify", 1, message_len, run_verify);
+		measure("sha512", 1, message_len, run_sha512);
+	}
+
+	measure("ecdsa_sign", 0, 0, run_ecdsa_sign);
+	measure("ecdsa_verify", 0, 0, run_ecdsa_verify);
+
+	if (json)
+		printf("\n  ]\n}\n");
+
+	free(message);
+	return 0;
+}
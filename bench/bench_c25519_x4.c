@@ -0,0 +1,81 @@
+/* Curve25519 batch key agreement throughput
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "c25519.h"
+
+#define MIN_SECONDS  1.0
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint8_t q[4 * F25519_SIZE];
+static uint8_t e[4 * C25519_EXPONENT_SIZE];
+static uint8_t r[4 * F25519_SIZE];
+
+static void run_single(void)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		c25519_smult(r + i * F25519_SIZE, q + i * F25519_SIZE,
+			     e + i * C25519_EXPONENT_SIZE);
+}
+
+static void run_x4(void)
+{
+	c25519_smult_x4(r, q, e);
+}
+
+/* Report key agreements per second, four per call */
+static double measure(const char *label, void (*fn)(void))
+{
+	const double start = now();
+	double elapsed;
+	unsigned long calls = 0;
+
+	fn();
+
+	do {
+		fn();
+		calls++;
+		elapsed = now() - start;
+	} while (elapsed < MIN_SECONDS);
+
+	printf("%-16s %10.0f agreements/s\n", label, calls * 4 / elapsed);
+	return calls * 4 / elapsed;
+}
+
+int main(void)
+{
+	double single;
+	double x4;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(q); i++)
+		q[i] = random();
+	for (i = 0; i < sizeof(e); i++)
+		e[i] = random();
+	for (i = 0; i < 4; i++) {
+		c25519_prepare(e + i * C25519_EXPONENT_SIZE);
+		c25519_base_smult(q + i * F25519_SIZE,
+				  e + ((i + 1) & 3) * C25519_EXPONENT_SIZE);
+	}
+
+	printf("c25519_smult_x4: %s, one core\n",
+	       c25519_smult_x4_native() ? "AVX2" : "fallback");
+	single = measure("c25519_smult", run_single);
+	x4 = measure("c25519_smult_x4", run_x4);
+	printf("%-16s %10.1fx\n", "speedup", x4 / single);
+
+	return 0;
+}
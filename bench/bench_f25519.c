@@ -0,0 +1,96 @@
+/* Field multiplication backends
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "f25519.h"
+#include "cpu.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+#define MIN_SECONDS  0.5
+#define CHAIN        1000
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Each product feeds the next, so that we measure latency rather than
+ * throughput, as in a ladder step.
+ */
+static void chain(f25519_mul_fn fn, uint8_t *x, const uint8_t *y)
+{
+	uint8_t t[F25519_SIZE];
+	int i;
+
+	for (i = 0; i < CHAIN; i += 2) {
+		fn(t, x, y);
+		fn(x, t, y);
+	}
+}
+
+static void measure(const char *name)
+{
+	const f25519_mul_fn fn = f25519_mul_backend(name);
+	uint8_t x[F25519_SIZE];
+	uint8_t y[F25519_SIZE];
+	unsigned long calls = 0;
+	double start;
+	double elapsed;
+#ifdef HAVE_RDTSC
+	unsigned long long tsc;
+#endif
+	unsigned int i;
+
+	if (!fn) {
+		printf("%-10s %12s\n", name, "unavailable");
+		return;
+	}
+
+	for (i = 0; i < F25519_SIZE; i++) {
+		x[i] = random();
+		y[i] = random();
+	}
+
+	chain(fn, x, y);
+
+	start = now();
+#ifdef HAVE_RDTSC
+	tsc = __rdtsc();
+#endif
+
+	do {
+		chain(fn, x, y);
+		calls += CHAIN;
+		elapsed = now() - start;
+	} while (elapsed < MIN_SECONDS);
+
+#ifdef HAVE_RDTSC
+	printf("%-10s %10.1f ns %10.1f cycles\n", name,
+	       elapsed * 1e9 / calls, (double)(__rdtsc() - tsc) / calls);
+#else
+	printf("%-10s %10.1f ns\n", name, elapsed * 1e9 / calls);
+#endif
+}
+
+int main(void)
+{
+	printf("f25519_mul__distinct: %s (cycles are TSC ticks)\n",
+	       cpu_dispatch()->f25519);
+
+	measure("portable");
+	measure("radix51");
+	measure("mulx");
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+/* Signature and key agreement throughput, for comparing build modes
+ *
+ * This file is in the public domain.
+ *
+ * The same source is linked against the separately compiled objects,
+ * against the amalgamation (c25519_all.c) and, with C25519_HEADER_ONLY
+ * defined, built header-only from c25519_all.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(C25519_HEADER_ONLY)
+#define C25519_IMPLEMENTATION
+#include "c25519_all.h"
+#define BUILD  "header-only"
+#else
+#include "c25519.h"
+#include "edsign.h"
+#ifdef C25519_AMALGAMATION
+#define BUILD  "amalgamated"
+#else
+#define BUILD  "separate"
+#endif
+#endif
+
+#define MIN_SECONDS  1.0
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint8_t secret[EDSIGN_SECRET_KEY_SIZE];
+static uint8_t pub[EDSIGN_PUBLIC_KEY_SIZE];
+static uint8_t sig[EDSIGN_SIGNATURE_SIZE];
+static uint8_t msg[64];
+
+static uint8_t e[C25519_EXPONENT_SIZE];
+static uint8_t q[F25519_SIZE];
+static uint8_t r[F25519_SIZE];
+
+static void run_sign(void)
+{
+	edsign_sign(sig, pub, secret, msg, sizeof(msg));
+}
+
+static void run_verify(void)
+{
+	if (!edsign_verify(sig, pub, msg, sizeof(msg)))
+		abort();
+}
+
+static void run_smult(void)
+{
+	c25519_smult(r, q, e);
+}
+
+static void measure(const char *label, void (*fn)(void))
+{
+	const double start = now();
+	double elapsed;
+	unsigned long calls = 0;
+
+	fn();
+
+	do {
+		fn();
+		calls++;
+		elapsed = now() - start;
+	} while (elapsed < MIN_SECONDS);
+
+	printf("%-14s %-12s %10.0f ops/s\n", label, BUILD, calls / elapsed);
+}
+
+int main(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(secret); i++)
+		secret[i] = random();
+	for (i = 0; i < sizeof(msg); i++)
+		msg[i] = random();
+	for (i = 0; i < sizeof(e); i++)
+		e[i] = random();
+
+	edsign_sec_to_pub(pub, secret);
+	edsign_sign(sig, pub, secret, msg, sizeof(msg));
+	c25519_prepare(e);
+	c25519_base_smult(q, e);
+
+	measure("edsign_sign", run_sign);
+	measure("edsign_verify", run_verify);
+	measure("c25519_smult", run_smult);
+
+	return 0;
+}
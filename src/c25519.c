@@ -5,6 +5,7 @@
  */
 
 #include "c25519.h"
+#include "ed25519.h"
 
 const uint8_t c25519_base_x[F25519_SIZE] = {9};
 const uint8_t c25519_base_y[F25519_SIZE] = {
@@ -38,7 +39,7 @@ static void xc_double(uint8_t *x3, uint8_t *z3,
 	f25519_mul__distinct(x3, a, a);
 
 	f25519_mul_c(a, x1z1, 486662);
-	f25519_add(a, x1sq, a);
+	f25519_add__lazy(a, x1sq, a);
 	f25519_add(a, z1sq, a);
 	f25519_mul__distinct(x1sq, x1z1, a);
 	f25519_mul_c(z3, x1sq, 4);
@@ -69,15 +70,15 @@ static void xc_diffadd(uint8_t *x5, uint8_t *z5,
 	uint8_t a[F25519_SIZE];
 	uint8_t b[F25519_SIZE];
 
-	f25519_add(a, x2, z2);
+	f25519_add__lazy(a, x2, z2);
 	f25519_sub(b, x3, z3); /* D */
 	f25519_mul__distinct(da, a, b);
 
 	f25519_sub(b, x2, z2);
-	f25519_add(a, x3, z3); /* C */
+	f25519_add__lazy(a, x3, z3); /* C */
 	f25519_mul__distinct(cb, a, b);
 
-	f25519_add(a, da, cb);
+	f25519_add__lazy(a, da, cb);
 	f25519_mul__distinct(b, a, a);
 	f25519_mul__distinct(x5, z1, b);
 
@@ -86,48 +87,49 @@ static void xc_diffadd(uint8_t *x5, uint8_t *z5,
 	f25519_mul__distinct(z5, x1, b);
 }
 
+/* Montgomery ladder, as given in RFC 7748. On return, (xm : zm) holds
+ * P_m and (xm1 : zm1) holds P_(m+1), where m is e with bit 255 cleared
+ * and bit 254 set.
+ */
 static void projective_ladder(
 				uint8_t *xm, uint8_t *zm,
 				uint8_t *xm1, uint8_t *zm1,
 				const uint8_t *q, const uint8_t *e)
 {
+	uint8_t swap = 0;
 	int i;
 
-	/* Note: bit 254 is assumed to be 1 */
-	f25519_copy(xm, q);
+	f25519_copy(xm, f25519_one);
+	f25519_copy(zm, f25519_zero);
+	f25519_copy(xm1, q);
+	f25519_copy(zm1, f25519_one);
+
+	for (i = 254; i >= 0; i--) {
+		const uint8_t bit = (i == 254) ? 1 :
+			((e[i >> 3] >> (i & 7)) & 1);
 
-	for (i = 253; i >= 0; i--) {
-		const int bit = (e[i >> 3] >> (i & 7)) & 1;
-		uint8_t xms[F25519_SIZE];
-		uint8_t zms[F25519_SIZE];
+		f25519_cswap(xm, xm1, swap ^ bit);
+		f25519_cswap(zm, zm1, swap ^ bit);
+		swap = bit;
 
-		/* From P_m and P_(m-1), compute P_(2m) and P_(2m-1) */
+		/* From P_m and P_(m+1), compute P_(2m+1) and P_(2m) */
 		xc_diffadd(xm1, zm1, q, f25519_one, xm, zm, xm1, zm1);
 		xc_double(xm, zm, xm, zm);
-
-		/* Compute P_(2m+1) */
-		xc_diffadd(xms, zms, xm1, zm1, xm, zm, q, f25519_one);
-
-		/* Select:
-		 *   bit = 1 --> (P_(2m+1), P_(2m))
-		 *   bit = 0 --> (P_(2m), P_(2m-1))
-		 */
-		f25519_select(xm1, xm1, xm, bit);
-		f25519_select(zm1, zm1, zm, bit);
-		f25519_select(xm, xm, xms, bit);
-		f25519_select(zm, zm, zms, bit);
 	}
+
+	f25519_cswap(xm, xm1, swap);
+	f25519_cswap(zm, zm1, swap);
 }
 
 void c25519_smult(uint8_t *result, const uint8_t *q, const uint8_t *e)
 {
 	/* Current point: P_m */
 	uint8_t xm[F25519_SIZE];
-	uint8_t zm[F25519_SIZE] = {1};
+	uint8_t zm[F25519_SIZE];
 
-	/* Predecessor: P_(m-1) */
-	uint8_t xm1[F25519_SIZE] = {1};
-	uint8_t zm1[F25519_SIZE] = {0};
+	/* Successor: P_(m+1) */
+	uint8_t xm1[F25519_SIZE];
+	uint8_t zm1[F25519_SIZE];
 
 	projective_ladder(xm, zm, xm1, zm1, q, e);
 
@@ -137,22 +139,52 @@ void c25519_smult(uint8_t *result, const uint8_t *q, const uint8_t *e)
 	f25519_normalize(result);
 }
 
+void c25519_base_smult(uint8_t *result, const uint8_t *e)
+{
+	struct ed25519_pt p;
+	uint8_t k[C25519_EXPONENT_SIZE];
+	uint8_t n[F25519_SIZE];
+	uint8_t d[F25519_SIZE];
+
+	/* The ladder ignores bit 255 and assumes bit 254 is set */
+	memcpy(k, e, sizeof(k));
+	k[31] &= 0x7f;
+	k[31] |= 0x40;
+
+	ed25519_smult_base(&p, k);
+
+	/* Map to the Montgomery curve. This is morph25519_ey2mx() applied
+	 * to y = Y/Z, with the division folded into a single inversion:
+	 *
+	 *     x = (1 + y) / (1 - y) = (Z + Y) / (Z - Y)
+	 */
+	f25519_sub(n, p.z, p.y);
+	f25519_inv__distinct(d, n);
+	f25519_add__lazy(n, p.z, p.y);
+	f25519_mul__distinct(result, n, d);
+	f25519_normalize(result);
+}
+
 void c25519_smult_xy(uint8_t *xR, uint8_t *yR, const uint8_t *xP, const uint8_t *yP, const uint8_t *e)
 {
 	/* Current point: P_m */
 	uint8_t xm[F25519_SIZE];
-	uint8_t zm[F25519_SIZE] = {1};
+	uint8_t zm[F25519_SIZE];
 
-	/* Predecessor: P_(m-1) */
-	uint8_t xm1[F25519_SIZE] = {1};
-	uint8_t zm1[F25519_SIZE] = {0};
+	/* Successor: P_(m+1) */
+	uint8_t xm1[F25519_SIZE];
+	uint8_t zm1[F25519_SIZE];
 
 	/* Calculate x(P) using Montgomery ladder */
 	projective_ladder(xm, zm, xm1, zm1, xP, e);
 
-	/* Recover y-coordinate */
+	/* Recover y-coordinate. Recovery takes x(Q - P); since
+	 * Q + P = Q - (-P), pass -P along with the successor.
+	 */
 	uint8_t xQ[F25519_SIZE], yQ[F25519_SIZE], zQ[F25519_SIZE];
-	morph25519_montgomery_recovery(xQ, yQ, zQ, xP, yP, xm, zm, xm1, zm1);
+	uint8_t nyP[F25519_SIZE];
+	f25519_neg(nyP, yP);
+	morph25519_montgomery_recovery(xQ, yQ, zQ, xP, nyP, xm, zm, xm1, zm1);
 
 	/* Freeze out of projective coordinates */
 	f25519_inv__distinct(zm, zQ);
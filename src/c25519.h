@@ -48,6 +48,31 @@ extern const uint8_t c25519_base_y[F25519_SIZE];
  */
 void c25519_smult(uint8_t *result, const uint8_t *q, const uint8_t *e);
 
+/* Fixed-base scalar multiply: return the X-coordinate of e*B, where B
+ * is the base point. This gives the same result as
+ *
+ *     c25519_smult(result, c25519_base_x, e)
+ *
+ * but is computed on the Edwards curve using a precomputed table, which
+ * is several times faster than the ladder. Use it to generate public
+ * keys.
+ */
+void c25519_base_smult(uint8_t *result, const uint8_t *e);
+
+/* Four independent X-coordinate scalar multiplies:
+ *
+ *     result[i] = c25519_smult(q[i], e[i])  (i = 0..3)
+ *
+ * Each of result, q and e points to four consecutive 32-byte values.
+ * On x86 CPUs with AVX2, the four ladders are computed in parallel
+ * vector lanes. Otherwise, this falls back to four calls to
+ * c25519_smult(). Both give identical results.
+ */
+void c25519_smult_x4(uint8_t *result, const uint8_t *q, const uint8_t *e);
+
+/* Return non-zero if c25519_smult_x4() runs in parallel on this CPU */
+int c25519_smult_x4_native(void);
+
 /*
  * Full scalar multiply: given (xP, yP), return (xR, yR) of e*P
  */
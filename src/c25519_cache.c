@@ -0,0 +1,120 @@
+/* Curve25519 shared-secret cache
+ *
+ * This file is in the public domain.
+ */
+
+#include "c25519_cache.h"
+#include "sha512.h"
+
+/* Keys are hashed with a prefix, so that the cache key is never the
+ * same as an Ed25519 key expansion of the same secret.
+ */
+static const char key_prefix[] = "c25519 cache key";
+
+static void wipe(void *p, size_t len)
+{
+	volatile uint8_t *v = p;
+
+	while (len--)
+		*(v++) = 0;
+}
+
+static void derive_key(uint8_t *key, const uint8_t *e)
+{
+	uint8_t block[SHA512_BLOCK_SIZE];
+	const size_t plen = sizeof(key_prefix) - 1;
+	struct sha512_state s;
+
+	memcpy(block, key_prefix, plen);
+	memcpy(block + plen, e, C25519_EXPONENT_SIZE);
+
+	sha512_init(&s);
+	sha512_final(&s, block, plen + C25519_EXPONENT_SIZE);
+	sha512_get(&s, key, 0, C25519_CACHE_KEY_SIZE);
+
+	wipe(block, sizeof(block));
+	wipe(&s, sizeof(s));
+}
+
+/* Return 1 if the two byte strings are equal, in constant time */
+static uint8_t bytes_eq(const uint8_t *x, const uint8_t *y, size_t len)
+{
+	uint8_t sum = 0;
+
+	while (len--)
+		sum |= *(x++) ^ *(y++);
+
+	return ((((uint32_t)sum) - 1) >> 31) & 1;
+}
+
+/* Return 1 if a < b, in constant time */
+static uint8_t less_than(uint64_t a, uint64_t b)
+{
+	return (a ^ ((a ^ b) | ((a - b) ^ b))) >> 63;
+}
+
+void c25519_cache_init(struct c25519_cache *c)
+{
+	wipe(c, sizeof(*c));
+}
+
+void c25519_cache_wipe(struct c25519_cache *c)
+{
+	wipe(c, sizeof(*c));
+}
+
+uint8_t c25519_cache_smult(struct c25519_cache *c, uint8_t *result,
+			   const uint8_t *q, const uint8_t *e)
+{
+	uint8_t key[C25519_CACHE_KEY_SIZE];
+	uint8_t found[F25519_SIZE] = {0};
+	uint8_t hit = 0;
+	unsigned int victim = 0;
+	uint64_t oldest = UINT64_MAX;
+	unsigned int i;
+
+	derive_key(key, e);
+	c->clock++;
+
+	/* Examine every entry. The matching entry (if any) is merged
+	 * into found and marked as used. At the same time, track the
+	 * least recently used entry as a candidate for eviction.
+	 */
+	for (i = 0; i < C25519_CACHE_ENTRIES; i++) {
+		struct c25519_cache_entry *ent = &c->entries[i];
+		const uint8_t match = bytes_eq(ent->key, key, sizeof(key)) &
+			bytes_eq(ent->peer, q, F25519_SIZE) &
+			less_than(0, ent->used);
+		const uint64_t mask = -(uint64_t)match;
+		const uint8_t older = less_than(ent->used, oldest);
+		const uint64_t omask = -(uint64_t)older;
+
+		f25519_select(found, found, ent->shared, match);
+		ent->used ^= mask & (ent->used ^ c->clock);
+		hit |= match;
+
+		victim ^= omask & (victim ^ i);
+		oldest ^= omask & (oldest ^ ent->used);
+	}
+
+	if (hit) {
+		f25519_copy(result, found);
+		wipe(found, sizeof(found));
+		wipe(key, sizeof(key));
+		return 1;
+	}
+
+	/* Miss: compute, then replace the least recently used entry */
+	c25519_smult(found, q, e);
+
+	wipe(&c->entries[victim], sizeof(c->entries[victim]));
+	memcpy(c->entries[victim].key, key, sizeof(key));
+	f25519_copy(c->entries[victim].peer, q);
+	f25519_copy(c->entries[victim].shared, found);
+	c->entries[victim].used = c->clock;
+
+	f25519_copy(result, found);
+	wipe(found, sizeof(found));
+	wipe(key, sizeof(key));
+	return 0;
+}
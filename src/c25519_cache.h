@@ -0,0 +1,61 @@
+/* Curve25519 shared-secret cache
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef C25519_CACHE_H_
+#define C25519_CACHE_H_
+
+#include <stdint.h>
+#include "c25519.h"
+
+/* A fixed-size cache of Diffie-Hellman results, for peers whose public
+ * keys don't change between exchanges (for example, when rekeying a
+ * long-lived tunnel with static keys).
+ *
+ * Entries are keyed by a hash of our secret and by the peer's public
+ * key. Secrets themselves are never stored. Lookups examine every entry
+ * and take the same time whichever entry matches, but a miss is still
+ * distinguishable from a hit, because a miss performs a full scalar
+ * multiplication.
+ *
+ * When the cache is full, the least recently used entry is wiped and
+ * replaced.
+ */
+#ifndef C25519_CACHE_ENTRIES
+#define C25519_CACHE_ENTRIES  8
+#endif
+
+#define C25519_CACHE_KEY_SIZE  32
+
+struct c25519_cache_entry {
+	uint8_t   key[C25519_CACHE_KEY_SIZE];
+	uint8_t   peer[F25519_SIZE];
+	uint8_t   shared[F25519_SIZE];
+
+	/* Time of last use, or 0 if the entry is empty. The clock is 64
+	 * bits wide so that it never wraps back to 0.
+	 */
+	uint64_t  used;
+};
+
+struct c25519_cache {
+	struct c25519_cache_entry  entries[C25519_CACHE_ENTRIES];
+	uint64_t                   clock;
+};
+
+/* Set up an empty cache */
+void c25519_cache_init(struct c25519_cache *c);
+
+/* Erase all entries */
+void c25519_cache_wipe(struct c25519_cache *c);
+
+/* Compute the same result as c25519_smult(result, q, e), returning a
+ * cached value if this pair of (q, e) has been seen recently.
+ *
+ * Returns 1 if the result came from the cache, 0 otherwise.
+ */
+uint8_t c25519_cache_smult(struct c25519_cache *c, uint8_t *result,
+			   const uint8_t *q, const uint8_t *e);
+
+#endif
@@ -0,0 +1,118 @@
+/* Curve25519 (Montgomery form), four ladders at a time
+ *
+ * This file is in the public domain.
+ */
+
+#include "c25519.h"
+#include "cpu.h"
+#include "fe4.h"
+
+#ifdef FE4_AVX2
+
+static AVX2 void smult_x4_avx2(uint8_t *result, const uint8_t *q,
+			       const uint8_t *e)
+{
+	struct fe4 x1, x2, z2, x3, z3;
+	struct fe4 a, aa, b, bb, c, d, t;
+	uint8_t k[4][C25519_EXPONENT_SIZE];
+	int swap[4] = {0};
+	int i, j;
+
+	/* The byte-oriented ladder ignores bit 255 and assumes that
+	 * bit 254 is set. Do the same, so that results agree.
+	 */
+	for (j = 0; j < 4; j++) {
+		memcpy(k[j], e + j * C25519_EXPONENT_SIZE,
+		       C25519_EXPONENT_SIZE);
+		k[j][31] &= 0x7f;
+		k[j][31] |= 0x40;
+	}
+
+	fe4_load(&x1, q);
+	fe4_carry(&x1);
+
+	memset(&x2, 0, sizeof(x2));
+	memset(&z2, 0, sizeof(z2));
+	memset(&z3, 0, sizeof(z3));
+	x2.l[0] = _mm256_set1_epi64x(1);
+	z3.l[0] = _mm256_set1_epi64x(1);
+	x3 = x1;
+
+	/* Montgomery ladder, as given in RFC 7748. (x2 : z2) holds P_m and
+	 * (x3 : z3) holds P_(m+1).
+	 */
+	for (i = 254; i >= 0; i--) {
+		int64_t m[4];
+
+		for (j = 0; j < 4; j++) {
+			const int bit = (k[j][i >> 3] >> (i & 7)) & 1;
+
+			m[j] = -(int64_t)(swap[j] ^ bit);
+			swap[j] = bit;
+		}
+
+		t.l[0] = _mm256_set_epi64x(m[3], m[2], m[1], m[0]);
+		fe4_cswap(&x2, &x3, t.l[0]);
+		fe4_cswap(&z2, &z3, t.l[0]);
+
+		fe4_add(&a, &x2, &z2);
+		fe4_mul(&aa, &a, &a);
+		fe4_sub(&b, &x2, &z2);
+		fe4_mul(&bb, &b, &b);
+
+		fe4_add(&c, &x3, &z3);
+		fe4_sub(&d, &x3, &z3);
+		fe4_mul(&d, &d, &a);		/* DA */
+		fe4_mul(&c, &c, &b);		/* CB */
+
+		fe4_add(&t, &d, &c);
+		fe4_mul(&x3, &t, &t);
+		fe4_sub(&t, &d, &c);
+		fe4_mul(&t, &t, &t);
+		fe4_mul(&z3, &x1, &t);
+
+		fe4_mul(&x2, &aa, &bb);
+		fe4_sub(&t, &aa, &bb);		/* E */
+		fe4_mul_c(&a, &t, 121665);
+		fe4_add(&a, &aa, &a);
+		fe4_mul(&z2, &t, &a);
+	}
+
+	t.l[0] = _mm256_set_epi64x(-(int64_t)swap[3], -(int64_t)swap[2],
+				   -(int64_t)swap[1], -(int64_t)swap[0]);
+	fe4_cswap(&x2, &x3, t.l[0]);
+	fe4_cswap(&z2, &z3, t.l[0]);
+
+	/* Freeze out of projective coordinates */
+	fe4_inv(&t, &z2);
+	fe4_mul(&x2, &x2, &t);
+	fe4_store(result, &x2);
+}
+
+#endif /* FE4_AVX2 */
+
+int c25519_smult_x4_native(void)
+{
+#ifdef FE4_AVX2
+	return cpu_features() & CPU_AVX2;
+#else
+	return 0;
+#endif
+}
+
+void c25519_smult_x4(uint8_t *result, const uint8_t *q, const uint8_t *e)
+{
+	int i;
+
+#ifdef FE4_AVX2
+	if (c25519_smult_x4_native()) {
+		smult_x4_avx2(result, q, e);
+		return;
+	}
+#endif
+
+	for (i = 0; i < 4; i++)
+		c25519_smult(result + i * F25519_SIZE,
+			     q + i * F25519_SIZE,
+			     e + i * C25519_EXPONENT_SIZE);
+}
@@ -0,0 +1,167 @@
+/* Runtime CPU feature detection and backend dispatch
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "cpu.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <cpuid.h>
+
+static unsigned int detect(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+	unsigned int xcr0 = 0;
+	unsigned int f = 0;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return 0;
+
+	/* The OS must save the vector registers before we can use them */
+	if (ecx & bit_OSXSAVE) {
+		unsigned int hi;
+
+		__asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(hi) : "c"(0));
+	}
+
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return 0;
+
+	if (ebx & bit_BMI2)
+		f |= CPU_BMI2;
+	if (ebx & bit_ADX)
+		f |= CPU_ADX;
+
+	/* XMM and YMM state */
+	if ((xcr0 & 0x06) == 0x06 && (ebx & bit_AVX2))
+		f |= CPU_AVX2;
+
+	return f;
+}
+#else
+static unsigned int detect(void)
+{
+	return 0;
+}
+#endif
+
+static int portable(void)
+{
+#ifdef C25519_PORTABLE
+	return 1;
+#else
+	const char *e = getenv("C25519_PORTABLE");
+
+	return e && *e && strcmp(e, "0");
+#endif
+}
+
+static void fill(struct cpu_dispatch *d)
+{
+	const int p = portable();
+	const unsigned int f = p ? 0 : detect();
+
+	d->features = f;
+	d->f25519 = "portable";
+
+#ifdef __SIZEOF_INT128__
+	if (!p)
+		d->f25519 = "radix51";
+#endif
+
+	if ((f & (CPU_BMI2 | CPU_ADX)) == (CPU_BMI2 | CPU_ADX))
+		d->f25519 = "mulx";
+
+	d->ed25519 = (f & CPU_AVX2) ? "avx2" : "portable";
+	d->c25519_x4 = (f & CPU_AVX2) ? "avx2" : "portable";
+}
+
+/* dispatch is written exactly once, by whichever thread moves the
+ * state from DISPATCH_EMPTY to DISPATCH_BUSY. Others wait until it is
+ * published as DISPATCH_READY, with release semantics.
+ */
+#define DISPATCH_EMPTY	0
+#define DISPATCH_BUSY	1
+#define DISPATCH_READY	2
+
+static struct cpu_dispatch dispatch;
+static int dispatch_state;
+
+const struct cpu_dispatch *cpu_dispatch(void)
+{
+#ifdef __GNUC__
+	int s = __atomic_load_n(&dispatch_state, __ATOMIC_ACQUIRE);
+
+	if (s == DISPATCH_READY)
+		return &dispatch;
+
+	if (s == DISPATCH_EMPTY &&
+	    __atomic_compare_exchange_n(&dispatch_state, &s, DISPATCH_BUSY,
+					0, __ATOMIC_ACQUIRE,
+					__ATOMIC_ACQUIRE)) {
+		struct cpu_dispatch d;
+
+		fill(&d);
+		dispatch = d;
+		__atomic_store_n(&dispatch_state, DISPATCH_READY,
+				 __ATOMIC_RELEASE);
+		return &dispatch;
+	}
+
+	while (__atomic_load_n(&dispatch_state, __ATOMIC_ACQUIRE) !=
+	       DISPATCH_READY)
+		;
+#else
+	/* Without atomics, the first call must not race with others */
+	if (dispatch_state != DISPATCH_READY) {
+		fill(&dispatch);
+		dispatch_state = DISPATCH_READY;
+	}
+#endif
+
+	return &dispatch;
+}
+
+unsigned int cpu_features(void)
+{
+	return cpu_dispatch()->features;
+}
+
+size_t cpu_feature_names(char *buf, size_t size, unsigned int features)
+{
+	static const struct {
+		unsigned int	bit;
+		const char	*name;
+	} names[] = {
+		{CPU_BMI2, "bmi2"},
+		{CPU_ADX, "adx"},
+		{CPU_AVX2, "avx2"}
+	};
+	size_t len = 0;
+	unsigned int i;
+
+	if (!size)
+		return 0;
+
+	buf[0] = 0;
+
+	for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		const size_t n = strlen(names[i].name);
+
+		if (!(features & names[i].bit))
+			continue;
+
+		if (len + !!len + n + 1 > size)
+			break;
+
+		if (len)
+			buf[len++] = ' ';
+
+		memcpy(buf + len, names[i].name, n + 1);
+		len += n;
+	}
+
+	return len;
+}
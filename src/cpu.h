@@ -0,0 +1,49 @@
+/* Runtime CPU feature detection and backend dispatch
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef CPU_H_
+#define CPU_H_
+
+#include <stddef.h>
+
+/* Features which some backend uses. These are taken from CPUID (and
+ * XGETBV, for the vector state) on x86-64. Elsewhere, none are
+ * reported.
+ */
+#define CPU_BMI2       0x0001
+#define CPU_ADX        0x0002
+#define CPU_AVX2       0x0004
+
+/* Features detected on first use. Defining C25519_PORTABLE at compile
+ * time, or setting the environment variable C25519_PORTABLE to a
+ * non-empty value other than "0", reports no features at all, forcing
+ * the portable byte-oriented code everywhere. This is meant for
+ * testing the fallback paths on hardware which would never take them.
+ *
+ * Detection is thread-safe when built with GCC or Clang. Otherwise,
+ * the first call must complete before any other thread uses the
+ * library.
+ */
+unsigned int cpu_features(void);
+
+/* Backends chosen for each subsystem, for logging. Each is "portable"
+ * unless an accelerated implementation was selected.
+ */
+struct cpu_dispatch {
+	unsigned int	features;
+
+	const char	*f25519;	/* field multiplication */
+	const char	*ed25519;	/* point arithmetic */
+	const char	*c25519_x4;	/* batch ladder */
+};
+
+const struct cpu_dispatch *cpu_dispatch(void);
+
+/* Format a set of features as a space-separated list of names. Returns
+ * the number of characters written, excluding the terminator.
+ */
+size_t cpu_feature_names(char *buf, size_t size, unsigned int features);
+
+#endif
@@ -4,15 +4,13 @@
  */
 #include "ed25519.h"
 #include "fprime.h"
+#include "sc25519.h"
 #include "ecdsa.h"
 #include "morph25519.h"
 
-static const uint8_t n[FPRIME_SIZE] = {
-	0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
-	0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
-};
+/* The order n of Wei25519 is the same as that of Ed25519, so scalar
+ * arithmetic mod n is done by sc25519.
+ */
 
 static void rshift(uint8_t* A, int t){
 	for (int j = 0; j < t; j++) {
@@ -36,14 +34,9 @@ void ecdsa_pubkey(uint8_t *wx, uint8_t *wy, const uint8_t *secret)
 	morph25519_e2w(wx, wy, ex, ey);
 }
 
-uint8_t ecdsa_sign(uint8_t *r, uint8_t *s, const uint8_t *d,
-		 const uint8_t *e, const uint8_t *k)
+/* The offline part of signing: compute r from k alone */
+static uint8_t sign_r(uint8_t *r, const uint8_t *k)
 {
-	uint8_t t[FPRIME_SIZE], z[FPRIME_SIZE];
-
-	if (fprime_eq(k, fprime_zero))
-		return 0;
-
 	struct ed25519_pt p1;
 	uint8_t ex[F25519_SIZE], ey[F25519_SIZE];
 	uint8_t wx[F25519_SIZE], wy[F25519_SIZE];
@@ -53,28 +46,26 @@ uint8_t ecdsa_sign(uint8_t *r, uint8_t *s, const uint8_t *d,
 	morph25519_e2w(wx, wy, ex, ey);
 
 	// 5. Calculate r = x_1 \pmod{n}.
-	fprime_from_bytes(r, wx, F25519_SIZE, n);
+	sc25519_from_bytes(r, wx, F25519_SIZE);
 
 	// 5. If r = 0, go back to step 3.
-	if (fprime_eq(r, fprime_zero))
-		return 0;
+	return fprime_eq(r, fprime_zero) ^ 1;
+}
 
-	// 6. Calculate s = k^{-1}(z + r d) \pmod{n}:
-	// 6. r * d
-	fprime_mul(t, r, d, n);
-	//fprime_normalize(t,n);
+/* The online part of signing, given r and kinv = k^-1 mod n */
+static uint8_t sign_s(uint8_t *s, const uint8_t *r, const uint8_t *d,
+		      const uint8_t *e, const uint8_t *kinv)
+{
+	uint8_t z[FPRIME_SIZE];
 
+	// 6. Calculate s = k^{-1}(z + r d) \pmod{n}:
 	// 6. z + (r d)
 	fprime_copy(z, e);
 	rshift(z,3);
-	fprime_add(z, t, n);
-
-	// 6. k^{-1}
-	fprime_inv(t, k, n);
+	sc25519_muladd(z, r, d, z);
 
 	// 6. s = (k^{-1}) (z + (r d))
-	fprime_mul(s, t, z, n);
-	fprime_normalize(s, n);
+	sc25519_mul(s, kinv, z);
 
 	// 6. If s = 0, go back to step 3.
 	if (fprime_eq(s, fprime_zero))
@@ -83,41 +74,380 @@ uint8_t ecdsa_sign(uint8_t *r, uint8_t *s, const uint8_t *d,
 	return 1;
 }
 
-uint8_t ecdsa_verify(const uint8_t *x, const uint8_t *y,
-		      const uint8_t *e, const uint8_t *r, const uint8_t *s)
+/* Sign, given kinv = k^-1 mod n */
+static uint8_t sign_with_inv(uint8_t *r, uint8_t *s, const uint8_t *d,
+			     const uint8_t *e, const uint8_t *k,
+			     const uint8_t *kinv)
 {
-	struct ed25519_pt p1;
-	struct ed25519_pt p2;
-	struct ed25519_pt Q;
-	uint8_t w[FPRIME_SIZE], z[FPRIME_SIZE];
-	uint8_t u1[FPRIME_SIZE], u2[FPRIME_SIZE];
-	uint8_t ex[F25519_SIZE], ey[F25519_SIZE];
-	uint8_t wx[F25519_SIZE], wy[F25519_SIZE];
+	if (!sign_r(r, k))
+		return 0;
+
+	return sign_s(s, r, d, e, kinv);
+}
+
+uint8_t ecdsa_sign(uint8_t *r, uint8_t *s, const uint8_t *d,
+		 const uint8_t *e, const uint8_t *k)
+{
+	uint8_t t[FPRIME_SIZE];
+
+	if (fprime_eq(k, fprime_zero))
+		return 0;
+
+	// 6. k^{-1}
+	sc25519_inv(t, k);
+
+	return sign_with_inv(r, s, d, e, k, t);
+}
+
+/* 2^255 - 19 */
+static const uint8_t field_p[F25519_SIZE] = {
+	0xed, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f
+};
+
+/* Warning: this function is variable-time */
+static int bytes_less_than(const uint8_t *a, const uint8_t *b)
+{
+	int i;
+
+	for (i = F25519_SIZE - 1; i >= 0; i--)
+		if (a[i] != b[i])
+			return a[i] < b[i];
+
+	return 0;
+}
+
+/* Check that r = x_1 mod n, where x_1 is the Weierstrass x-coordinate
+ * of the projective Edwards point P. Since x_1 < p < 8n, x_1 must be
+ * one of r + jn for 0 <= j < 8 (and less than p). Each candidate is
+ * compared without leaving projective coordinates, which saves the two
+ * inversions of ed25519_unproject() and morph25519_e2w(). Everything
+ * here is public, so we may return early.
+ */
+static uint8_t check_r(const uint8_t *r, const struct ed25519_pt *p)
+{
+	uint8_t x[F25519_SIZE];
+	int j;
+
+	if (fprime_eq(r, fprime_zero) || !bytes_less_than(r, sc25519_order))
+		return 0;
+
+	fprime_copy(x, r);
+
+	for (j = 0; j < 8 && bytes_less_than(x, field_p); j++) {
+		uint16_t c = 0;
+		int i;
+
+		if (morph25519_wx_eq_ey(x, p->y, p->z))
+			return 1;
+
+		for (i = 0; i < F25519_SIZE; i++) {
+			c += x[i] + sc25519_order[i];
+			x[i] = c;
+			c >>= 8;
+		}
+	}
+
+	return 0;
+}
+
+/* Compute the two scalars u1 = zw, u2 = rw */
+static void verify_scalars(uint8_t *u1, uint8_t *u2, const uint8_t *e,
+			   const uint8_t *r, const uint8_t *w)
+{
+	uint8_t z[FPRIME_SIZE];
 
 	// 3. Let z be the L_n leftmost bits of e
 	fprime_copy(z, e);
 	rshift(z,3);
 
-	// 4. Calculate w = s^-1 mod n
-	fprime_inv(w, s, n);
-
 	// 5. Calculate u_1 = zw mod n
-	fprime_mul(u1, z, w, n);
+	sc25519_mul(u1, z, w);
 
 	// and  u_2 = r*w mod n
-	fprime_mul(u2, r, w, n);
+	sc25519_mul(u2, r, w);
+}
+
+/* Verify, given w = s^-1 mod n */
+static uint8_t verify_with_inv(const uint8_t *x, const uint8_t *y,
+			       const uint8_t *e, const uint8_t *r,
+			       const uint8_t *w)
+{
+	struct ed25519_pt p1;
+	struct ed25519_pt p2;
+	struct ed25519_pt Q;
+	uint8_t u1[FPRIME_SIZE], u2[FPRIME_SIZE];
+	uint8_t ex[F25519_SIZE], ey[F25519_SIZE];
+
+	verify_scalars(u1, u2, e, r, w);
 
 	// 5. Calculate the curve point (x_1, y_1) = u_1 * G + u_2 * Q_A.
 	// tmp1 = u_1 * G
 	morph25519_w2e(ex, ey, x, y);
 	ed25519_project(&Q, ex, ey);
-	ed25519_smult(&p1, &ed25519_base, u1);
-	ed25519_smult(&p2, &Q, u2);
+	ed25519_smult_base(&p1, u1);
+	ed25519_smult_vartime(&p2, &Q, u2);
 	ed25519_add(&Q, &p1, &p2);
-	ed25519_unproject(ex, ey, &Q);
-	morph25519_e2w(wx, wy, ex, ey);
 
 	// 7. The signature is valid of r == x1 mod n
-	fprime_normalize(wx, n);
-	return f25519_eq(wx, r);
+	return check_r(r, &Q);
+}
+
+uint8_t ecdsa_verify(const uint8_t *x, const uint8_t *y,
+		      const uint8_t *e, const uint8_t *r, const uint8_t *s)
+{
+	uint8_t w[FPRIME_SIZE];
+
+	// 4. Calculate w = s^-1 mod n
+	sc25519_inv(w, s);
+
+	return verify_with_inv(x, y, e, r, w);
+}
+
+static void wipe_secret(void *p, size_t len)
+{
+	volatile uint8_t *v = p;
+
+	while (len--)
+		*(v++) = 0;
+}
+
+/* Invert count <= ECDSA_BATCH_SIZE scalars at once, by Montgomery's
+ * trick: one inversion and 3(count - 1) multiplications. Each x[i] is
+ * replaced by its inverse, and ok[i] is set to one if it was non-zero.
+ * Zero elements are treated as one, so that they don't spoil the rest
+ * of the batch.
+ */
+static void batch_inv(uint8_t *x, uint8_t *ok, size_t count)
+{
+	uint8_t acc[ECDSA_BATCH_SIZE][SC25519_SIZE];
+	uint8_t t[SC25519_SIZE];
+	uint8_t u[SC25519_SIZE];
+	size_t i;
+
+	/* acc[i] = x[0] x[1] ... x[i] */
+	for (i = 0; i < count; i++) {
+		uint8_t *xi = x + i * SC25519_SIZE;
+
+		sc25519_from_bytes(t, xi, SC25519_SIZE);
+		ok[i] = fprime_eq(t, fprime_zero) ^ 1;
+		fprime_select(xi, fprime_one, t, ok[i]);
+
+		if (i)
+			sc25519_mul(acc[i], acc[i - 1], xi);
+		else
+			fprime_copy(acc[0], xi);
+	}
+
+	/* t = (x[0] ... x[i])^-1, working downwards */
+	sc25519_inv(t, acc[count - 1]);
+
+	for (i = count - 1; i > 0; i--) {
+		uint8_t *xi = x + i * SC25519_SIZE;
+
+		sc25519_mul(u, t, acc[i - 1]);
+		sc25519_mul(t, t, xi);
+		fprime_copy(xi, u);
+	}
+
+	fprime_copy(x, t);
+
+	/* When signing, these are products of secret nonces */
+	wipe_secret(acc, sizeof(acc));
+	wipe_secret(t, sizeof(t));
+	wipe_secret(u, sizeof(u));
+}
+
+size_t ecdsa_sign_batch(uint8_t *ok, uint8_t *r, uint8_t *s,
+			const uint8_t *d, const uint8_t *e,
+			const uint8_t *k, size_t count)
+{
+	uint8_t kinv[ECDSA_BATCH_SIZE * SC25519_SIZE];
+	size_t total = 0;
+
+	while (count) {
+		const size_t len =
+			count < ECDSA_BATCH_SIZE ? count : ECDSA_BATCH_SIZE;
+		size_t i;
+
+		memcpy(kinv, k, len * SC25519_SIZE);
+		batch_inv(kinv, ok, len);
+
+		for (i = 0; i < len; i++) {
+			const size_t o = i * SC25519_SIZE;
+
+			/* batch_inv() replaced a zero k with one. Signing
+			 * with that would publish s = z + rd, and with it
+			 * the private key, so skip the entry entirely.
+			 */
+			if (!ok[i])
+				continue;
+
+			ok[i] = sign_with_inv(r + o, s + o, d + o, e + o,
+					      k + o, kinv + o);
+			total += ok[i];
+		}
+
+		ok += len;
+		r += len * SC25519_SIZE;
+		s += len * SC25519_SIZE;
+		d += len * SC25519_SIZE;
+		e += len * SC25519_SIZE;
+		k += len * SC25519_SIZE;
+		count -= len;
+	}
+
+	wipe_secret(kinv, sizeof(kinv));
+	return total;
+}
+
+size_t ecdsa_verify_batch(uint8_t *ok, const uint8_t *x, const uint8_t *y,
+			  const uint8_t *e, const uint8_t *r,
+			  const uint8_t *s, size_t count)
+{
+	uint8_t w[ECDSA_BATCH_SIZE * SC25519_SIZE];
+	size_t total = 0;
+
+	while (count) {
+		const size_t len =
+			count < ECDSA_BATCH_SIZE ? count : ECDSA_BATCH_SIZE;
+		size_t i;
+
+		memcpy(w, s, len * SC25519_SIZE);
+		batch_inv(w, ok, len);
+
+		for (i = 0; i < len; i++) {
+			const size_t o = i * SC25519_SIZE;
+
+			ok[i] &= verify_with_inv(x + o, y + o, e + o, r + o,
+						 w + o);
+			total += ok[i];
+		}
+
+		ok += len;
+		x += len * F25519_SIZE;
+		y += len * F25519_SIZE;
+		e += len * SC25519_SIZE;
+		r += len * SC25519_SIZE;
+		s += len * SC25519_SIZE;
+		count -= len;
+	}
+
+	return total;
+}
+
+void ecdsa_pubkey_prepare(struct ecdsa_pubkey *pk,
+			  const uint8_t *x, const uint8_t *y)
+{
+	struct ed25519_pt Q;
+	uint8_t ex[F25519_SIZE], ey[F25519_SIZE];
+
+	morph25519_w2e(ex, ey, x, y);
+	ed25519_project(&Q, ex, ey);
+	ed25519_window_init(&pk->q, &Q);
+}
+
+uint8_t ecdsa_verify_prepared(const struct ecdsa_pubkey *pk,
+			      const uint8_t *e, const uint8_t *r,
+			      const uint8_t *s)
+{
+	struct ed25519_pt p1;
+	struct ed25519_pt p2;
+	uint8_t u1[FPRIME_SIZE], u2[FPRIME_SIZE];
+	uint8_t w[FPRIME_SIZE];
+
+	sc25519_inv(w, s);
+	verify_scalars(u1, u2, e, r, w);
+
+	ed25519_smult_base(&p1, u1);
+	ed25519_smult_window(&p2, &pk->q, u2);
+	ed25519_add(&p1, &p1, &p2);
+
+	return check_r(r, &p1);
+}
+
+uint8_t ecdsa_presign(struct ecdsa_presig *p, const uint8_t *k)
+{
+	uint8_t t[SC25519_SIZE];
+
+	sc25519_from_bytes(t, k, SC25519_SIZE);
+	if (fprime_eq(t, fprime_zero) || !sign_r(p->r, k)) {
+		wipe_secret(p, sizeof(*p));
+		return 0;
+	}
+
+	sc25519_inv(p->kinv, t);
+	wipe_secret(t, sizeof(t));
+	return 1;
+}
+
+uint8_t ecdsa_sign_presig(uint8_t *r, uint8_t *s, const uint8_t *d,
+			  const uint8_t *e, struct ecdsa_presig *p)
+{
+	uint8_t ret;
+
+	/* An unused (or wiped) tuple has r = 0 */
+	if (fprime_eq(p->r, fprime_zero))
+		return 0;
+
+	fprime_copy(r, p->r);
+	ret = sign_s(s, r, d, e, p->kinv);
+	wipe_secret(p, sizeof(*p));
+
+	return ret;
+}
+
+/* Pool indices are free-running counters. The producer owns head and
+ * the consumer owns tail; each reads the other's with acquire
+ * semantics, and publishes its own with release semantics, after the
+ * slot contents have been written (or wiped).
+ */
+#ifdef __GNUC__
+#define load_acquire(x)		__atomic_load_n(x, __ATOMIC_ACQUIRE)
+#define store_release(x, v)	__atomic_store_n(x, v, __ATOMIC_RELEASE)
+#else
+#define load_acquire(x)		(*(x))
+#define store_release(x, v)	(*(x) = (v))
+#endif
+
+void ecdsa_presig_pool_init(struct ecdsa_presig_pool *pool)
+{
+	wipe_secret(pool, sizeof(*pool));
+}
+
+uint8_t ecdsa_presig_pool_put(struct ecdsa_presig_pool *pool,
+			      struct ecdsa_presig *p)
+{
+	const unsigned int head = pool->head;
+
+	if (head - load_acquire(&pool->tail) >= ECDSA_PRESIG_POOL_SIZE)
+		return 0;
+
+	pool->slots[head % ECDSA_PRESIG_POOL_SIZE] = *p;
+	wipe_secret(p, sizeof(*p));
+	store_release(&pool->head, head + 1);
+	return 1;
+}
+
+uint8_t ecdsa_presig_pool_get(struct ecdsa_presig_pool *pool,
+			      struct ecdsa_presig *p)
+{
+	const unsigned int tail = pool->tail;
+	struct ecdsa_presig *slot;
+
+	if (load_acquire(&pool->head) == tail)
+		return 0;
+
+	slot = &pool->slots[tail % ECDSA_PRESIG_POOL_SIZE];
+	*p = *slot;
+	wipe_secret(slot, sizeof(*slot));
+	store_release(&pool->tail, tail + 1);
+	return 1;
+}
+
+unsigned int ecdsa_presig_pool_count(const struct ecdsa_presig_pool *pool)
+{
+	return load_acquire(&pool->head) - load_acquire(&pool->tail);
 }
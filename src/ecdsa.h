@@ -9,6 +9,8 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "fprime.h"
+#include "sc25519.h"
+#include "ed25519.h"
 
 /*
  * Generate an ecdsa public key (x,y of an affine point on Wei25519)
@@ -64,4 +66,139 @@ uint8_t ecdsa_sign(uint8_t *r, uint8_t *s, const uint8_t *d,
 uint8_t ecdsa_verify(const uint8_t *x, const uint8_t *y,
 		      const uint8_t *e, const uint8_t *r, const uint8_t *s);
 
+/**
+ * Prepared public keys.
+ *
+ * When many signatures are checked against one key, the conversion of
+ * the key to Edwards coordinates can be done once, along with a table
+ * of its small multiples. ecdsa_verify_prepared() gives the same result
+ * as ecdsa_verify(), but is faster. A prepared key takes 1.5 kB.
+ */
+struct ecdsa_pubkey {
+	struct ed25519_window	q;
+};
+
+void ecdsa_pubkey_prepare(struct ecdsa_pubkey *pk,
+			  const uint8_t *x, const uint8_t *y);
+
+uint8_t ecdsa_verify_prepared(const struct ecdsa_pubkey *pk,
+			      const uint8_t *e, const uint8_t *r,
+			      const uint8_t *s);
+
+/**
+ * Batch signing and verification.
+ *
+ * These are equivalent to calling ecdsa_sign() or ecdsa_verify() once
+ * for each of count entries, but all k (or s) values in a batch are
+ * inverted together, using Montgomery's trick: one modular inversion
+ * plus 3(count - 1) multiplications. Each argument other than ok and
+ * count is an array of count 32-byte values, laid out contiguously.
+ *
+ * Batches larger than ECDSA_BATCH_SIZE are processed in chunks of that
+ * size, which bounds stack usage at about 64 * ECDSA_BATCH_SIZE bytes.
+ *
+ * output:
+ *  ok: for each entry, the value that ecdsa_sign() or ecdsa_verify()
+ *      would have returned. An entry with k = 0 mod n (or s = 0 mod n)
+ *      is rejected, without affecting the others. The r and s of a
+ *      rejected signing entry are left untouched.
+ *
+ * return:
+ *  the number of entries for which ok is 1
+ */
+#ifndef ECDSA_BATCH_SIZE
+#define ECDSA_BATCH_SIZE	16
+#endif
+
+size_t ecdsa_sign_batch(uint8_t *ok, uint8_t *r, uint8_t *s,
+			const uint8_t *d, const uint8_t *e,
+			const uint8_t *k, size_t count);
+
+size_t ecdsa_verify_batch(uint8_t *ok, const uint8_t *x, const uint8_t *y,
+			  const uint8_t *e, const uint8_t *r,
+			  const uint8_t *s, size_t count);
+
+/**
+ * Presignatures.
+ *
+ * Everything in ecdsa_sign() that depends only on k -- the scalar
+ * multiplication, the conversion to Weierstrass coordinates and the
+ * inversion of k -- can be done ahead of time, before the message is
+ * known. The result is a presignature tuple (r, k^-1). The online step
+ * is then a multiply-add and a multiply mod n.
+ *
+ * A tuple must never be used for more than one signature: doing so
+ * reveals the private key. ecdsa_sign_presig() therefore wipes the
+ * tuple it is given, and refuses to use a wiped tuple.
+ */
+struct ecdsa_presig {
+	uint8_t		r[SC25519_SIZE];
+	uint8_t		kinv[SC25519_SIZE];
+};
+
+/**
+ * Compute a presignature from random data k (32 bytes), which must be
+ * freshly generated for each tuple.
+ *
+ * return:
+ *   1: everything is ok
+ *   0: k is unusable and the tuple is wiped, try again with another k.
+ */
+uint8_t ecdsa_presign(struct ecdsa_presig *p, const uint8_t *k);
+
+/**
+ * Complete a signature, consuming a presignature. The arguments and
+ * return value are otherwise as for ecdsa_sign(). Given
+ * p = ecdsa_presign(k), this produces the same signature as
+ * ecdsa_sign(r, s, d, e, k).
+ */
+uint8_t ecdsa_sign_presig(uint8_t *r, uint8_t *s, const uint8_t *d,
+			  const uint8_t *e, struct ecdsa_presig *p);
+
+/**
+ * A bounded pool of presignatures.
+ *
+ * This is a ring buffer which is safe for use by one producer thread
+ * (calling put) and one consumer thread (calling get) at once, without
+ * locks. On GCC-compatible compilers, the indices are accessed with
+ * acquire/release atomics; otherwise, the pool is for use from a single
+ * thread only. Slots are wiped as they are consumed.
+ *
+ * The producer will typically call ecdsa_presign() in the background
+ * while ecdsa_presig_pool_count() is below some threshold.
+ *
+ * ECDSA_PRESIG_POOL_SIZE must be a power of two.
+ */
+#ifndef ECDSA_PRESIG_POOL_SIZE
+#define ECDSA_PRESIG_POOL_SIZE	16
+#endif
+
+#if ECDSA_PRESIG_POOL_SIZE & (ECDSA_PRESIG_POOL_SIZE - 1)
+#error "ECDSA_PRESIG_POOL_SIZE must be a power of two"
+#endif
+
+struct ecdsa_presig_pool {
+	struct ecdsa_presig	slots[ECDSA_PRESIG_POOL_SIZE];
+	unsigned int		head;
+	unsigned int		tail;
+};
+
+/* Initialize an empty pool */
+void ecdsa_presig_pool_init(struct ecdsa_presig_pool *pool);
+
+/* Move a presignature into the pool, wiping the original. Returns 1 on
+ * success, or 0 (leaving p intact) if the pool is full.
+ */
+uint8_t ecdsa_presig_pool_put(struct ecdsa_presig_pool *pool,
+			      struct ecdsa_presig *p);
+
+/* Take the oldest presignature out of the pool. Returns 1 on success,
+ * or 0 if the pool is empty.
+ */
+uint8_t ecdsa_presig_pool_get(struct ecdsa_presig_pool *pool,
+			      struct ecdsa_presig *p);
+
+/* Return the number of presignatures available */
+unsigned int ecdsa_presig_pool_count(const struct ecdsa_presig_pool *pool);
+
 #endif
@@ -145,16 +145,74 @@ uint8_t ed25519_try_unpack(uint8_t *x, uint8_t *y, const uint8_t *comp)
 	return f25519_eq(a, c);
 }
 
-/* k = 2d */
-static const uint8_t ed25519_k[F25519_SIZE] = {
+const uint8_t ed25519_k[F25519_SIZE] = {
 	0x59, 0xf1, 0xb2, 0x26, 0x94, 0x9b, 0xd6, 0xeb,
 	0x56, 0xb1, 0x83, 0x82, 0x9a, 0x14, 0xe0, 0x00,
 	0x30, 0xd1, 0xf3, 0xee, 0xf2, 0x80, 0x8e, 0x19,
 	0xe7, 0xfc, 0xdf, 0x56, 0xdc, 0xd9, 0x06, 0x24
 };
 
-void ed25519_add(struct ed25519_pt *r,
-		 const struct ed25519_pt *p1, const struct ed25519_pt *p2)
+const struct ed25519_pt_p2 ed25519_neutral_p2 = {
+	.x = {0},
+	.y = {1, 0},
+	.z = {1, 0}
+};
+
+void ed25519_p1p1_to_p2(struct ed25519_pt_p2 *r,
+			const struct ed25519_pt_p1p1 *p)
+{
+	f25519_mul__distinct(r->x, p->x, p->t);
+	f25519_mul__distinct(r->y, p->y, p->z);
+	f25519_mul__distinct(r->z, p->z, p->t);
+}
+
+void ed25519_p1p1_to_p3(struct ed25519_pt *r,
+			const struct ed25519_pt_p1p1 *p)
+{
+	f25519_mul__distinct(r->x, p->x, p->t);
+	f25519_mul__distinct(r->y, p->y, p->z);
+	f25519_mul__distinct(r->t, p->x, p->y);
+	f25519_mul__distinct(r->z, p->z, p->t);
+}
+
+void ed25519_p3_to_p2(struct ed25519_pt_p2 *r, const struct ed25519_pt *p)
+{
+	f25519_copy(r->x, p->x);
+	f25519_copy(r->y, p->y);
+	f25519_copy(r->z, p->z);
+}
+
+/* (X : Y : Z) -> (XZ : YZ : XY : Z^2) */
+static void p2_to_p3(struct ed25519_pt *r, const struct ed25519_pt_p2 *p)
+{
+	f25519_mul__distinct(r->x, p->x, p->z);
+	f25519_mul__distinct(r->y, p->y, p->z);
+	f25519_mul__distinct(r->t, p->x, p->y);
+	f25519_mul__distinct(r->z, p->z, p->z);
+}
+
+const struct ed25519_pt_cached ed25519_neutral_cached = {
+	.ypx = {1, 0},
+	.ymx = {1, 0},
+	.t2d = {0},
+	.z2 = {2, 0}
+};
+
+void ed25519_to_cached(struct ed25519_pt_cached *r,
+		       const struct ed25519_pt *p)
+{
+	/* The coordinates of p may come from the caller, and so may
+	 * both be relaxed: these sums need the full reduction.
+	 */
+	f25519_add(r->ypx, p->y, p->x);
+	f25519_sub(r->ymx, p->y, p->x);
+	f25519_mul__distinct(r->t2d, p->t, ed25519_k);
+	f25519_add(r->z2, p->z, p->z);
+}
+
+void ed25519_add_cached_p1p1(struct ed25519_pt_p1p1 *r,
+			     const struct ed25519_pt *p1,
+			     const struct ed25519_pt_cached *p2)
 {
 	/* Explicit formulas database: add-2008-hwcd-3
 	 *
@@ -175,6 +233,8 @@ void ed25519_add(struct ed25519_pt *r,
 	 * compute Y3 = G H
 	 * compute T3 = E H
 	 * compute Z3 = F G
+	 *
+	 * Here, Y2-X2, Y2+X2, k T2 and 2 Z2 are precomputed.
 	 */
 	uint8_t a[F25519_SIZE];
 	uint8_t b[F25519_SIZE];
@@ -187,21 +247,17 @@ void ed25519_add(struct ed25519_pt *r,
 
 	/* A = (Y1-X1)(Y2-X2) */
 	f25519_sub(c, p1->y, p1->x);
-	f25519_sub(d, p2->y, p2->x);
-	f25519_mul__distinct(a, c, d);
+	f25519_mul__distinct(a, c, p2->ymx);
 
 	/* B = (Y1+X1)(Y2+X2) */
 	f25519_add(c, p1->y, p1->x);
-	f25519_add(d, p2->y, p2->x);
-	f25519_mul__distinct(b, c, d);
+	f25519_mul__distinct(b, c, p2->ypx);
 
 	/* C = T1 k T2 */
-	f25519_mul__distinct(d, p1->t, p2->t);
-	f25519_mul__distinct(c, d, ed25519_k);
+	f25519_mul__distinct(c, p1->t, p2->t2d);
 
 	/* D = Z1 2 Z2 */
-	f25519_mul__distinct(d, p1->z, p2->z);
-	f25519_add(d, d, d);
+	f25519_mul__distinct(d, p1->z, p2->z2);
 
 	/* E = B - A */
 	f25519_sub(e, b, a);
@@ -210,25 +266,152 @@ void ed25519_add(struct ed25519_pt *r,
 	f25519_sub(f, d, c);
 
 	/* G = D + C */
-	f25519_add(g, d, c);
+	f25519_add__lazy(g, d, c);
 
 	/* H = B + A */
-	f25519_add(h, b, a);
+	f25519_add__lazy(h, b, a);
+
+	/* Completed form: x = E/G, y = H/F. The final multiplications,
+	 * X3 = E F, Y3 = G H, T3 = E H and Z3 = F G, are left to the
+	 * conversion functions.
+	 */
+	f25519_copy(r->x, e);
+	f25519_copy(r->y, h);
+	f25519_copy(r->z, g);
+	f25519_copy(r->t, f);
+}
+
+const struct ed25519_pt_niels ed25519_neutral_niels = {
+	.ypx = {1, 0},
+	.ymx = {1, 0},
+	.xy2d = {0}
+};
+
+void ed25519_madd_p1p1(struct ed25519_pt_p1p1 *r,
+		       const struct ed25519_pt *p1,
+		       const struct ed25519_pt_niels *p2)
+{
+	/* Explicit formulas database: madd-2008-hwcd-3
+	 *
+	 * As for add-2008-hwcd-3, but with Z2 = 1, so that D = 2 Z1.
+	 */
+	uint8_t a[F25519_SIZE];
+	uint8_t b[F25519_SIZE];
+	uint8_t c[F25519_SIZE];
+	uint8_t d[F25519_SIZE];
+	uint8_t e[F25519_SIZE];
+	uint8_t f[F25519_SIZE];
+	uint8_t g[F25519_SIZE];
+	uint8_t h[F25519_SIZE];
+
+	/* A = (Y1-X1)(y2-x2) */
+	f25519_sub(c, p1->y, p1->x);
+	f25519_mul__distinct(a, c, p2->ymx);
 
-	/* X3 = E F */
-	f25519_mul__distinct(r->x, e, f);
+	/* B = (Y1+X1)(y2+x2) */
+	f25519_add(c, p1->y, p1->x);
+	f25519_mul__distinct(b, c, p2->ypx);
 
-	/* Y3 = G H */
-	f25519_mul__distinct(r->y, g, h);
+	/* C = T1 k t2 */
+	f25519_mul__distinct(c, p1->t, p2->xy2d);
 
-	/* T3 = E H */
-	f25519_mul__distinct(r->t, e, h);
+	/* D = 2 Z1 */
+	f25519_add(d, p1->z, p1->z);
 
-	/* Z3 = F G */
-	f25519_mul__distinct(r->z, f, g);
+	/* E = B - A */
+	f25519_sub(e, b, a);
+
+	/* F = D - C */
+	f25519_sub(f, d, c);
+
+	/* G = D + C */
+	f25519_add__lazy(g, d, c);
+
+	/* H = B + A */
+	f25519_add__lazy(h, b, a);
+
+	/* Completed form: x = E/G, y = H/F. The final multiplications,
+	 * X3 = E F, Y3 = G H, T3 = E H and Z3 = F G, are left to the
+	 * conversion functions.
+	 */
+	f25519_copy(r->x, e);
+	f25519_copy(r->y, h);
+	f25519_copy(r->z, g);
+	f25519_copy(r->t, f);
 }
 
-void ed25519_double(struct ed25519_pt *r, const struct ed25519_pt *p)
+void ed25519_to_niels_batch(struct ed25519_pt_niels *r,
+			    const struct ed25519_pt *p, unsigned int count)
+{
+	uint8_t inv[F25519_SIZE];
+	uint8_t zinv[F25519_SIZE];
+	uint8_t x[F25519_SIZE];
+	uint8_t y[F25519_SIZE];
+	unsigned int i;
+
+	if (!count)
+		return;
+
+	/* Prefix products Z[0] Z[1] ... Z[i], kept in r[i].xy2d */
+	f25519_copy(r[0].xy2d, p[0].z);
+	for (i = 1; i < count; i++)
+		f25519_mul__distinct(r[i].xy2d, r[i - 1].xy2d, p[i].z);
+
+	f25519_inv__distinct(inv, r[count - 1].xy2d);
+
+	/* Working downwards, inv = (Z[0] ... Z[i])^-1 */
+	for (i = count; i-- > 0; ) {
+		if (i) {
+			f25519_mul__distinct(zinv, inv, r[i - 1].xy2d);
+			f25519_mul__distinct(x, inv, p[i].z);
+			f25519_copy(inv, x);
+		} else {
+			f25519_copy(zinv, inv);
+		}
+
+		f25519_mul__distinct(x, p[i].x, zinv);
+		f25519_mul__distinct(y, p[i].y, zinv);
+
+		f25519_add(r[i].ypx, y, x);
+		f25519_sub(r[i].ymx, y, x);
+		f25519_mul__distinct(zinv, x, y);
+		f25519_mul__distinct(r[i].xy2d, zinv, ed25519_k);
+
+		f25519_normalize(r[i].ypx);
+		f25519_normalize(r[i].ymx);
+		f25519_normalize(r[i].xy2d);
+	}
+}
+
+void ed25519_add_cached(struct ed25519_pt *r, const struct ed25519_pt *a,
+			const struct ed25519_pt_cached *b)
+{
+	struct ed25519_pt_p1p1 c;
+
+	ed25519_add_cached_p1p1(&c, a, b);
+	ed25519_p1p1_to_p3(r, &c);
+}
+
+void ed25519_madd(struct ed25519_pt *r, const struct ed25519_pt *a,
+		  const struct ed25519_pt_niels *b)
+{
+	struct ed25519_pt_p1p1 c;
+
+	ed25519_madd_p1p1(&c, a, b);
+	ed25519_p1p1_to_p3(r, &c);
+}
+
+void ed25519_add(struct ed25519_pt *r,
+		 const struct ed25519_pt *p1, const struct ed25519_pt *p2)
+{
+	struct ed25519_pt_cached c;
+
+	ed25519_to_cached(&c, p2);
+	ed25519_add_cached(r, p1, &c);
+}
+
+void ed25519_double_p1p1(struct ed25519_pt_p1p1 *r,
+			 const struct ed25519_pt_p2 *p)
 {
 	/* Explicit formulas database: dbl-2008-hwcd
 	 *
@@ -282,39 +465,629 @@ void ed25519_double(struct ed25519_pt *r, const struct ed25519_pt *p)
 	f25519_neg(h, b);
 	f25519_sub(h, h, a);
 
-	/* X3 = E F */
-	f25519_mul__distinct(r->x, e, f);
-
-	/* Y3 = G H */
-	f25519_mul__distinct(r->y, g, h);
+	/* Completed form: x = E/G, y = H/F. The final multiplications,
+	 * X3 = E F, Y3 = G H, T3 = E H and Z3 = F G, are left to the
+	 * conversion functions.
+	 */
+	f25519_copy(r->x, e);
+	f25519_copy(r->y, h);
+	f25519_copy(r->z, g);
+	f25519_copy(r->t, f);
+}
 
-	/* T3 = E H */
-	f25519_mul__distinct(r->t, e, h);
+void ed25519_double(struct ed25519_pt *r, const struct ed25519_pt *p)
+{
+	struct ed25519_pt_p1p1 c;
+	struct ed25519_pt_p2 q;
 
-	/* Z3 = F G */
-	f25519_mul__distinct(r->z, f, g);
+	ed25519_p3_to_p2(&q, p);
+	ed25519_double_p1p1(&c, &q);
+	ed25519_p1p1_to_p3(r, &c);
 }
 
 void ed25519_smult(struct ed25519_pt *r_out, const struct ed25519_pt *p,
 		   const uint8_t *e)
 {
-	struct ed25519_pt r;
+	struct ed25519_pt_cached pc;
+	struct ed25519_pt_p2 r;
 	int i;
 
-	ed25519_copy(&r, &ed25519_neutral);
+	if (ed25519_x4_smult(r_out, p, e))
+		return;
+
+	memcpy(&r, &ed25519_neutral_p2, sizeof(r));
+	ed25519_to_cached(&pc, p);
 
+	/* The accumulator is only ever doubled, so it is kept without T */
 	for (i = 255; i >= 0; i--) {
 		const uint8_t bit = (e[i >> 3] >> (i & 7)) & 1;
-		struct ed25519_pt s;
+		struct ed25519_pt_p1p1 c;
+		struct ed25519_pt_p2 s[2];
+		struct ed25519_pt d;
+
+		ed25519_double_p1p1(&c, &r);
+		ed25519_p1p1_to_p3(&d, &c);
+		ed25519_p3_to_p2(&s[0], &d);
+		ed25519_add_cached_p1p1(&c, &d, &pc);
+		ed25519_p1p1_to_p2(&s[1], &c);
+
+		f25519_lookup(&r, s, sizeof(r), 2, bit);
+	}
+
+	p2_to_p3(r_out, &r);
+}
 
-		ed25519_double(&r, &r);
-		ed25519_add(&s, &r, p);
+/* Width of the non-adjacent form used by ed25519_smult_vartime(). The
+ * table holds the odd multiples 1, 3, ..., 2^(w-1) - 1.
+ */
+#define WNAF_WIDTH  5
+#define WNAF_LEN    (256 + WNAF_WIDTH)
+
+static int wnaf_bit(const uint8_t *e, int i)
+{
+	return (i < 256) ? ((e[i >> 3] >> (i & 7)) & 1) : 0;
+}
+
+/* Recode e as sum(naf[i] 2^i), where each non-zero digit is odd and
+ * less than 2^(w-1) in magnitude, and is followed by at least w - 1
+ * zeros. This is the algorithm used by libsecp256k1, and is
+ * variable-time. The extra digits beyond bit 255 absorb the final
+ * carry.
+ */
+static void wnaf_recode(int8_t *naf, const uint8_t *e)
+{
+	int carry = 0;
+	int i = 0;
+
+	memset(naf, 0, WNAF_LEN);
+
+	while (i < WNAF_LEN) {
+		int word = 0;
+		int j;
+
+		if (wnaf_bit(e, i) == carry) {
+			i++;
+			continue;
+		}
+
+		for (j = 0; j < WNAF_WIDTH; j++)
+			word |= wnaf_bit(e, i + j) << j;
+
+		word += carry;
+		carry = (word >> (WNAF_WIDTH - 1)) & 1;
+		naf[i] = word - (carry << WNAF_WIDTH);
+		i += WNAF_WIDTH;
+	}
+}
+
+void ed25519_smult_vartime(struct ed25519_pt *r_out,
+			   const struct ed25519_pt *p, const uint8_t *e)
+{
+	struct ed25519_pt_cached odd[1 << (WNAF_WIDTH - 2)];
+	int8_t naf[WNAF_LEN];
+	struct ed25519_pt_p1p1 c;
+	struct ed25519_pt_p2 r;
+	int i;
+
+	wnaf_recode(naf, e);
+
+	if (ed25519_x4_smult_wnaf(r_out, p, naf, WNAF_LEN))
+		return;
+
+	/* odd[i] = (2i + 1) p */
+	{
+		struct ed25519_pt_cached p2;
+		struct ed25519_pt m;
+
+		ed25519_double(&m, p);
+		ed25519_to_cached(&p2, &m);
+		ed25519_to_cached(&odd[0], p);
+		ed25519_copy(&m, p);
+
+		for (i = 1; i < (1 << (WNAF_WIDTH - 2)); i++) {
+			ed25519_add_cached(&m, &m, &p2);
+			ed25519_to_cached(&odd[i], &m);
+		}
+	}
+
+	for (i = WNAF_LEN - 1; i >= 0 && !naf[i]; i--)
+		;
 
-		f25519_select(r.x, r.x, s.x, bit);
-		f25519_select(r.y, r.y, s.y, bit);
-		f25519_select(r.z, r.z, s.z, bit);
-		f25519_select(r.t, r.t, s.t, bit);
+	memcpy(&r, &ed25519_neutral_p2, sizeof(r));
+
+	for (; i >= 0; i--) {
+		ed25519_double_p1p1(&c, &r);
+
+		if (naf[i]) {
+			const struct ed25519_pt_cached *a =
+				&odd[(naf[i] < 0 ? -naf[i] : naf[i]) >> 1];
+			struct ed25519_pt d;
+
+			ed25519_p1p1_to_p3(&d, &c);
+
+			if (naf[i] > 0) {
+				ed25519_add_cached_p1p1(&c, &d, a);
+			} else {
+				struct ed25519_pt_cached neg;
+
+				/* -(x, y) = (-x, y) */
+				f25519_copy(neg.ypx, a->ymx);
+				f25519_copy(neg.ymx, a->ypx);
+				f25519_neg(neg.t2d, a->t2d);
+				f25519_copy(neg.z2, a->z2);
+				ed25519_add_cached_p1p1(&c, &d, &neg);
+			}
+		}
+
+		ed25519_p1p1_to_p2(&r, &c);
 	}
 
-	ed25519_copy(r_out, &r);
+	p2_to_p3(r_out, &r);
+}
+
+/* Fixed-base comb for the base point B. The 256-bit exponent is split
+ * into four teeth of 64 bits each, and entry j of the table holds:
+ *
+ *     sum(2^(64i) B) for each bit i set in j
+ *
+ * Each column of four bits, one from each tooth, selects a table entry.
+ * Scalar multiplication then needs only 64 doublings and 64 mixed
+ * additions. Entries are stored in Niels form.
+ *
+ * The table is printed by tools/gen_base_comb, and "make check" fails
+ * if the two differ.
+ */
+#define BASE_COMB_TEETH    4
+#define BASE_COMB_SPACING  64
+
+static const struct ed25519_pt_niels base_comb[1 << BASE_COMB_TEETH] = {
+	{ /* 0 */
+		.ypx = {
+			0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+		},
+		.ymx = {
+			0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+		},
+		.xy2d = {
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+		}
+	},
+	{ /* 1 */
+		.ypx = {
+			0x85, 0x3b, 0x8c, 0xf5, 0xc6, 0x93, 0xbc, 0x2f,
+			0x19, 0x0e, 0x8c, 0xfb, 0xc6, 0x2d, 0x93, 0xcf,
+			0xc2, 0x42, 0x3d, 0x64, 0x98, 0x48, 0x0b, 0x27,
+			0x65, 0xba, 0xd4, 0x33, 0x3a, 0x9d, 0xcf, 0x07
+		},
+		.ymx = {
+			0x3e, 0x91, 0x40, 0xd7, 0x05, 0x39, 0x10, 0x9d,
+			0xb3, 0xbe, 0x40, 0xd1, 0x05, 0x9f, 0x39, 0xfd,
+			0x09, 0x8a, 0x8f, 0x68, 0x34, 0x84, 0xc1, 0xa5,
+			0x67, 0x12, 0xf8, 0x98, 0x92, 0x2f, 0xfd, 0x44
+		},
+		.xy2d = {
+			0x68, 0xaa, 0x7a, 0x87, 0x05, 0x12, 0xc9, 0xab,
+			0x9e, 0xc4, 0xaa, 0xcc, 0x23, 0xe8, 0xd9, 0x26,
+			0x8c, 0x59, 0x43, 0xdd, 0xcb, 0x7d, 0x1b, 0x5a,
+			0xa8, 0x65, 0x0c, 0x9f, 0x68, 0x7b, 0x11, 0x6f
+		}
+	},
+	{ /* 2 */
+		.ypx = {
+			0x15, 0xf5, 0xd1, 0x77, 0xe7, 0x65, 0x2a, 0xcd,
+			0xf1, 0x60, 0xaa, 0x8f, 0x87, 0x91, 0x89, 0x54,
+			0xe5, 0x06, 0xbc, 0xda, 0xbc, 0x3b, 0xb7, 0xb1,
+			0xfb, 0xc9, 0x7c, 0xa9, 0xcb, 0x78, 0x48, 0x65
+		},
+		.ymx = {
+			0xfe, 0xb0, 0xf6, 0x8d, 0xc7, 0x8e, 0x13, 0x51,
+			0x1b, 0xf5, 0x75, 0xe5, 0x89, 0xda, 0x97, 0x53,
+			0xb9, 0xf1, 0x7a, 0x71, 0x1d, 0x7a, 0x20, 0x09,
+			0x50, 0xd6, 0x20, 0x2b, 0xba, 0xfd, 0x02, 0x21
+		},
+		.xy2d = {
+			0xa1, 0xe6, 0x5c, 0x05, 0x05, 0xe4, 0x9e, 0x96,
+			0x29, 0xad, 0x51, 0x12, 0x68, 0xa7, 0xbc, 0x36,
+			0x15, 0xa4, 0x7d, 0xaa, 0x17, 0xf5, 0x1a, 0x3a,
+			0xba, 0xb2, 0xec, 0x29, 0xdb, 0x25, 0xd7, 0x0a
+		}
+	},
+	{ /* 3 */
+		.ypx = {
+			0xe8, 0x59, 0x1e, 0x60, 0x85, 0xc5, 0x55, 0x00,
+			0x60, 0x0e, 0x48, 0x66, 0x2b, 0x34, 0x93, 0x87,
+			0x4c, 0xe4, 0x45, 0xfe, 0xd0, 0xaa, 0x14, 0x3e,
+			0x2b, 0xcf, 0x13, 0x48, 0xe6, 0xd8, 0xea, 0x26
+		},
+		.ymx = {
+			0xa4, 0x62, 0x84, 0x9c, 0xb6, 0xb8, 0x75, 0xcb,
+			0xd7, 0x1c, 0xd3, 0x67, 0xc5, 0x6f, 0xd8, 0x2d,
+			0xf6, 0x42, 0x13, 0x88, 0xec, 0x72, 0x19, 0xcd,
+			0x2f, 0x2f, 0xc1, 0x0f, 0x97, 0xb5, 0x75, 0x09
+		},
+		.xy2d = {
+			0x43, 0xa7, 0x5b, 0xda, 0x03, 0x23, 0xcf, 0x63,
+			0x6e, 0xba, 0xf1, 0x52, 0x81, 0x9d, 0xbf, 0x04,
+			0xda, 0x67, 0x73, 0xaa, 0xd0, 0x90, 0x37, 0x33,
+			0xea, 0xc5, 0xf6, 0x9d, 0x47, 0x70, 0x46, 0x53
+		}
+	},
+	{ /* 4 */
+		.ypx = {
+			0xa2, 0x8e, 0xad, 0xac, 0xbf, 0x04, 0x3b, 0x58,
+			0x84, 0xe8, 0x8b, 0x14, 0xe8, 0x43, 0xb7, 0x29,
+			0xdb, 0xc5, 0x10, 0x08, 0x3b, 0x58, 0x1e, 0x2b,
+			0xaa, 0xbb, 0xb3, 0x8e, 0xe5, 0x49, 0x54, 0x2b
+		},
+		.ymx = {
+			0x47, 0xbe, 0x3d, 0xeb, 0x62, 0x75, 0x3a, 0x5f,
+			0xb8, 0xa0, 0xbd, 0x8e, 0x54, 0x38, 0xea, 0xf7,
+			0x99, 0x72, 0x74, 0x45, 0x31, 0xe5, 0xc3, 0x00,
+			0x51, 0xd5, 0x27, 0x16, 0xe7, 0xe9, 0x04, 0x13
+		},
+		.xy2d = {
+			0xfe, 0x9c, 0xdc, 0x6a, 0xd2, 0x14, 0x98, 0x78,
+			0x0b, 0xdd, 0x48, 0x8b, 0x3f, 0xab, 0x1b, 0x3c,
+			0x0a, 0xc6, 0x79, 0xf9, 0xff, 0xe1, 0x0f, 0xda,
+			0x93, 0xd6, 0x2d, 0x7c, 0x2d, 0xde, 0x68, 0x44
+		}
+	},
+	{ /* 5 */
+		.ypx = {
+			0x48, 0x67, 0xbc, 0xe3, 0x8d, 0x27, 0x18, 0x21,
+			0xf7, 0x0e, 0xb2, 0xd0, 0x60, 0xfd, 0x1f, 0xe7,
+			0x98, 0xb1, 0x7b, 0xc6, 0x51, 0xbe, 0x51, 0xf5,
+			0x4d, 0x3d, 0x54, 0xd0, 0x64, 0x36, 0xa1, 0x26
+		},
+		.ymx = {
+			0xee, 0x39, 0xa3, 0x13, 0x3b, 0x2d, 0x52, 0x29,
+			0x29, 0x95, 0xd8, 0x6c, 0x50, 0x25, 0x52, 0x85,
+			0xf1, 0xf0, 0xf4, 0xac, 0xd4, 0x3a, 0xea, 0xdf,
+			0x2e, 0x74, 0x42, 0x79, 0xba, 0x6b, 0xd7, 0x49
+		},
+		.xy2d = {
+			0x1d, 0xe6, 0x56, 0x8d, 0x33, 0x42, 0xfa, 0x14,
+			0x9a, 0x29, 0x51, 0xc3, 0x46, 0x39, 0x1d, 0x19,
+			0x85, 0xb1, 0xad, 0xa7, 0x6d, 0x57, 0x7d, 0x24,
+			0xc2, 0xed, 0xfc, 0xa8, 0xe3, 0xaf, 0x1f, 0x4e
+		}
+	},
+	{ /* 6 */
+		.ypx = {
+			0x4c, 0x04, 0x6a, 0x23, 0x3d, 0x05, 0xe7, 0x15,
+			0xe3, 0x87, 0x8d, 0x3b, 0xb1, 0xbc, 0xdd, 0x3c,
+			0x28, 0xa8, 0x21, 0xd3, 0xd2, 0x60, 0x99, 0x51,
+			0xa4, 0xbb, 0xc5, 0x0f, 0x0f, 0x9a, 0x55, 0x4e
+		},
+		.ymx = {
+			0x1c, 0x70, 0x12, 0x9c, 0x76, 0xe8, 0x00, 0xfe,
+			0x5f, 0x3b, 0x9c, 0x03, 0x0a, 0xdc, 0xdc, 0x95,
+			0x1b, 0xeb, 0x02, 0x0c, 0x4b, 0x45, 0x69, 0xc1,
+			0x0c, 0x53, 0x87, 0x5f, 0xd3, 0x21, 0x70, 0x72
+		},
+		.xy2d = {
+			0x1e, 0x24, 0xdf, 0x27, 0x07, 0x04, 0x71, 0xa5,
+			0x36, 0x0d, 0x90, 0xb2, 0xaa, 0xef, 0x45, 0xdf,
+			0xde, 0x9a, 0xa6, 0x60, 0x5c, 0xdb, 0x6e, 0xfe,
+			0x1d, 0xc0, 0xbb, 0x07, 0x30, 0xb7, 0xfc, 0x64
+		}
+	},
+	{ /* 7 */
+		.ypx = {
+			0xca, 0x90, 0xd3, 0x6f, 0xcc, 0x58, 0xef, 0x38,
+			0xfc, 0x98, 0x1a, 0x17, 0x75, 0x65, 0x78, 0xef,
+			0x5f, 0xd6, 0x42, 0xc4, 0x8f, 0xb7, 0x50, 0x88,
+			0xef, 0x86, 0xd0, 0x6f, 0x6d, 0xc6, 0x34, 0x6f
+		},
+		.ymx = {
+			0x04, 0xdc, 0x98, 0x38, 0xb4, 0xcb, 0xf3, 0x93,
+			0x27, 0xb7, 0x07, 0x43, 0xb2, 0xff, 0x91, 0x07,
+			0x1d, 0x98, 0x34, 0xce, 0x96, 0x80, 0xbd, 0xd7,
+			0x6d, 0x9f, 0x84, 0x8b, 0x8e, 0x8b, 0x59, 0x0b
+		},
+		.xy2d = {
+			0x89, 0xf6, 0xc2, 0x0c, 0x8a, 0xc1, 0xcf, 0x11,
+			0x2a, 0xce, 0x29, 0xb5, 0x07, 0x46, 0x11, 0x81,
+			0x40, 0x59, 0x0b, 0xc0, 0x46, 0xc0, 0x9b, 0x0a,
+			0xc8, 0x66, 0xac, 0xb1, 0xb0, 0x28, 0x21, 0x41
+		}
+	},
+	{ /* 8 */
+		.ypx = {
+			0xc0, 0x1a, 0x0c, 0xc8, 0x9d, 0xcc, 0x6d, 0xa6,
+			0x36, 0xa4, 0x38, 0x1b, 0xf4, 0x5c, 0xa0, 0x97,
+			0xc6, 0xd7, 0xdb, 0x95, 0xbe, 0xf3, 0xeb, 0xa7,
+			0xab, 0x7d, 0x7e, 0x8d, 0xf6, 0xb8, 0xa0, 0x7d
+		},
+		.ymx = {
+			0xa6, 0x75, 0x56, 0x38, 0x14, 0x20, 0x78, 0xef,
+			0xe8, 0xa9, 0xfd, 0xaa, 0x30, 0x9f, 0x64, 0xa2,
+			0xcb, 0xa8, 0xdf, 0x5c, 0x50, 0xeb, 0xd1, 0x4c,
+			0xb3, 0xc0, 0x4d, 0x1d, 0xba, 0x5a, 0x11, 0x46
+		},
+		.xy2d = {
+			0x76, 0xda, 0xb5, 0xc3, 0x53, 0x19, 0x0f, 0xd4,
+			0x9b, 0x9e, 0x11, 0x21, 0x73, 0x6f, 0xac, 0x1d,
+			0x60, 0x59, 0xb2, 0xfe, 0x21, 0x60, 0xcc, 0x03,
+			0x4b, 0x4b, 0x67, 0x83, 0x7e, 0x88, 0x5f, 0x5a
+		}
+	},
+	{ /* 9 */
+		.ypx = {
+			0xf4, 0xc1, 0xa2, 0x0c, 0x18, 0x60, 0x8d, 0x0a,
+			0x40, 0xdf, 0x68, 0xcc, 0xdb, 0xb0, 0x5e, 0x81,
+			0x99, 0x4e, 0x2f, 0xb8, 0x47, 0x7a, 0xe6, 0xd7,
+			0xc0, 0x15, 0x7f, 0x60, 0x90, 0x28, 0xa0, 0x45
+		},
+		.ymx = {
+			0x84, 0xf1, 0x41, 0xfd, 0xd1, 0x66, 0xf3, 0xfe,
+			0x1e, 0xe1, 0xcf, 0x01, 0x11, 0x4a, 0x69, 0x8b,
+			0x4d, 0xa7, 0x50, 0x01, 0x5e, 0xe1, 0x39, 0x4b,
+			0xba, 0x51, 0xd3, 0x6a, 0x3d, 0xf0, 0x13, 0x40
+		},
+		.xy2d = {
+			0xcc, 0x65, 0xe0, 0x6e, 0xdc, 0x82, 0x02, 0xbd,
+			0x46, 0xe6, 0x4a, 0x22, 0xfd, 0x94, 0xb9, 0x36,
+			0x74, 0xe8, 0xbc, 0xfe, 0xd8, 0x9a, 0x4e, 0x53,
+			0x4f, 0x6e, 0xf0, 0xd9, 0xc1, 0x55, 0x22, 0x48
+		}
+	},
+	{ /* 10 */
+		.ypx = {
+			0x00, 0xf8, 0xce, 0x71, 0xcf, 0xea, 0x03, 0x3c,
+			0xbb, 0xfe, 0x8a, 0xca, 0x44, 0x75, 0x36, 0x90,
+			0x77, 0xc4, 0x29, 0x6a, 0x28, 0xea, 0x3f, 0x38,
+			0x62, 0x54, 0x65, 0xbc, 0xb0, 0x93, 0x85, 0x4e
+		},
+		.ymx = {
+			0x8c, 0x63, 0xe5, 0xa3, 0x4a, 0x11, 0xde, 0x12,
+			0x0d, 0xf2, 0xc4, 0x29, 0xa9, 0x4a, 0x2a, 0xba,
+			0xa3, 0x13, 0x8b, 0x7b, 0x9d, 0xd2, 0xb0, 0x56,
+			0x44, 0x79, 0x9b, 0x7b, 0x49, 0x1a, 0xb9, 0x6b
+		},
+		.xy2d = {
+			0x06, 0xd2, 0xe7, 0xc5, 0x46, 0xe6, 0x49, 0x2a,
+			0x45, 0xc4, 0x63, 0x92, 0xcd, 0xf9, 0x3e, 0xb1,
+			0x9e, 0x52, 0xab, 0xed, 0xe8, 0x6c, 0xab, 0x50,
+			0x9b, 0xe3, 0xeb, 0xb0, 0x79, 0x7d, 0xcf, 0x20
+		}
+	},
+	{ /* 11 */
+		.ypx = {
+			0x48, 0x5c, 0xe7, 0x8a, 0x4e, 0x8f, 0xd2, 0xcb,
+			0x60, 0x0b, 0x00, 0x44, 0x91, 0x02, 0xde, 0x3c,
+			0x70, 0x21, 0xbc, 0x98, 0xc8, 0xb9, 0x3b, 0x37,
+			0x86, 0x08, 0x57, 0x9f, 0x53, 0x88, 0x11, 0x7c
+		},
+		.ymx = {
+			0xca, 0x7d, 0xfe, 0xf0, 0x9d, 0x93, 0xb4, 0x7d,
+			0xce, 0x51, 0xa9, 0xcb, 0x0f, 0xb9, 0x0e, 0xf5,
+			0x1d, 0x1d, 0x7e, 0x35, 0x1c, 0xe6, 0x8b, 0x09,
+			0x9d, 0x46, 0x99, 0x88, 0x37, 0x62, 0x35, 0x02
+		},
+		.xy2d = {
+			0x03, 0x4c, 0x5a, 0xe1, 0xfa, 0xef, 0xf6, 0x20,
+			0x05, 0x8e, 0x77, 0x3c, 0x94, 0x0a, 0x47, 0x2f,
+			0x67, 0xde, 0x99, 0xfc, 0x03, 0x0a, 0xf5, 0x79,
+			0x83, 0x14, 0x06, 0xd1, 0x88, 0x01, 0xd2, 0x38
+		}
+	},
+	{ /* 12 */
+		.ypx = {
+			0xdf, 0x15, 0x63, 0x0e, 0xad, 0x11, 0xe8, 0x23,
+			0x90, 0xb2, 0xae, 0xe2, 0x05, 0x0d, 0x65, 0x0b,
+			0x6c, 0x58, 0x5d, 0xa7, 0x59, 0x0f, 0xba, 0xb7,
+			0xee, 0x4d, 0x1f, 0x5e, 0xd4, 0xed, 0x3e, 0x04
+		},
+		.ymx = {
+			0x17, 0x32, 0x07, 0xc7, 0xf2, 0x47, 0xc1, 0xf6,
+			0x0c, 0xd2, 0xaf, 0xf3, 0x19, 0xb9, 0x51, 0xc6,
+			0x02, 0xf8, 0x41, 0x70, 0xfd, 0xdb, 0x8f, 0x25,
+			0x3e, 0x07, 0x45, 0x4f, 0xa9, 0x4f, 0x3c, 0x17
+		},
+		.xy2d = {
+			0xc4, 0xf9, 0x8d, 0x92, 0x60, 0xea, 0x71, 0x3d,
+			0x2d, 0x56, 0x73, 0x33, 0x06, 0x78, 0x7e, 0x5b,
+			0xb2, 0x52, 0x95, 0xa2, 0x4c, 0x51, 0xb0, 0xd9,
+			0x72, 0xc4, 0x3c, 0x99, 0x24, 0x70, 0x2a, 0x1e
+		}
+	},
+	{ /* 13 */
+		.ypx = {
+			0x1f, 0x81, 0x5c, 0xd4, 0xbc, 0x0f, 0x1a, 0x60,
+			0x03, 0x08, 0xec, 0x92, 0x7d, 0xbc, 0xb7, 0x24,
+			0x7f, 0x40, 0xd2, 0x17, 0x2b, 0xe6, 0xca, 0xa0,
+			0x26, 0x5b, 0x22, 0x06, 0xee, 0x43, 0xcb, 0x5f
+		},
+		.ymx = {
+			0xa4, 0xfb, 0x09, 0x35, 0xb9, 0x09, 0x05, 0x31,
+			0x75, 0x1b, 0x63, 0x05, 0x76, 0xb3, 0x8d, 0x0d,
+			0x87, 0x1c, 0x40, 0x52, 0xba, 0xcc, 0xde, 0x97,
+			0x73, 0xe7, 0xb2, 0x11, 0xf4, 0x49, 0x46, 0x04
+		},
+		.xy2d = {
+			0x5f, 0x21, 0x98, 0x95, 0xad, 0x24, 0x0d, 0x0c,
+			0x8c, 0x62, 0x36, 0xcc, 0x26, 0x90, 0x7f, 0x1b,
+			0xea, 0xdc, 0x16, 0x70, 0x55, 0x2f, 0x8e, 0x33,
+			0x8f, 0xe5, 0xc0, 0x5c, 0xfa, 0x1b, 0x8a, 0x0c
+		}
+	},
+	{ /* 14 */
+		.ypx = {
+			0x4c, 0x10, 0x1d, 0x68, 0xb5, 0x03, 0xe7, 0x8d,
+			0x45, 0xcb, 0x63, 0x12, 0x59, 0x7a, 0x2f, 0x3d,
+			0x63, 0x6c, 0xe5, 0x1c, 0x17, 0x0c, 0x71, 0xae,
+			0xca, 0xe6, 0xc3, 0xfc, 0x7e, 0x7c, 0x85, 0x6b
+		},
+		.ymx = {
+			0xc0, 0x01, 0x28, 0x8b, 0xb4, 0x56, 0xd2, 0x79,
+			0xc4, 0x0f, 0x40, 0x3c, 0xac, 0xbe, 0x9f, 0x7e,
+			0x41, 0xba, 0x33, 0x47, 0x1d, 0xab, 0x51, 0xa7,
+			0xca, 0x8a, 0x41, 0xdd, 0xf5, 0x2b, 0xde, 0x09
+		},
+		.xy2d = {
+			0x7f, 0x68, 0xf0, 0xef, 0xf3, 0x0f, 0xf1, 0x3b,
+			0xa2, 0x7b, 0xe3, 0xf1, 0x34, 0xea, 0xba, 0x5e,
+			0x4d, 0x03, 0x66, 0x1d, 0x26, 0x61, 0x9e, 0xe4,
+			0xca, 0x42, 0xb2, 0xc3, 0x2a, 0x6e, 0x46, 0x5b
+		}
+	},
+	{ /* 15 */
+		.ypx = {
+			0x42, 0xb8, 0xfb, 0x47, 0x67, 0xeb, 0x7e, 0x13,
+			0x8b, 0x1a, 0x81, 0x60, 0x75, 0x5c, 0xdf, 0x79,
+			0x9a, 0xc8, 0xf8, 0x71, 0x6f, 0xa7, 0x2b, 0x5a,
+			0xc2, 0xff, 0xc8, 0x3b, 0x56, 0x2a, 0x95, 0x09
+		},
+		.ymx = {
+			0x3c, 0xf8, 0x7e, 0xdc, 0x4b, 0xcb, 0xa8, 0xa2,
+			0x26, 0xc2, 0x93, 0x5f, 0xfa, 0xc6, 0xb5, 0x96,
+			0xa5, 0xe3, 0x64, 0x06, 0x1b, 0xeb, 0xeb, 0xd4,
+			0x2f, 0xcf, 0xc6, 0xe5, 0xdc, 0x4a, 0x9b, 0x40
+		},
+		.xy2d = {
+			0xc4, 0x50, 0x43, 0x83, 0xb9, 0x3d, 0xd5, 0x44,
+			0xb4, 0x05, 0xf5, 0xa5, 0x05, 0x93, 0x29, 0x89,
+			0x2f, 0xff, 0x49, 0x59, 0xa2, 0xfa, 0x22, 0xfb,
+			0x64, 0x7d, 0x65, 0x04, 0xa7, 0x68, 0xb9, 0x69
+		}
+	}
+};
+
+/* Constant-time lookup in a table of Niels points: every entry is
+ * read, regardless of idx.
+ */
+static void niels_select(struct ed25519_pt_niels *r,
+			 const struct ed25519_pt_niels *table,
+			 unsigned int count, unsigned int idx)
+{
+	f25519_lookup(r, table, sizeof(*r), count, idx);
+}
+
+void ed25519_smult_base(struct ed25519_pt *r_out, const uint8_t *e)
+{
+	uint8_t comb[BASE_COMB_SPACING];
+	struct ed25519_pt_p2 r;
+	int i;
+
+	for (i = 0; i < BASE_COMB_SPACING; i++) {
+		const int k = BASE_COMB_SPACING - 1 - i;
+		int j;
+
+		comb[i] = 0;
+		for (j = 0; j < BASE_COMB_TEETH; j++) {
+			const int bit = k + j * BASE_COMB_SPACING;
+
+			comb[i] |= ((e[bit >> 3] >> (bit & 7)) & 1) << j;
+		}
+	}
+
+	if (ed25519_x4_smult_niels(r_out, base_comb,
+				   1 << BASE_COMB_TEETH, comb,
+				   BASE_COMB_SPACING, 1))
+		return;
+
+	memcpy(&r, &ed25519_neutral_p2, sizeof(r));
+
+	for (i = BASE_COMB_SPACING - 1; i >= 0; i--) {
+		struct ed25519_pt_niels s;
+		struct ed25519_pt_p1p1 c;
+		struct ed25519_pt d;
+
+		niels_select(&s, base_comb, 1 << BASE_COMB_TEETH,
+			     comb[BASE_COMB_SPACING - 1 - i]);
+		ed25519_double_p1p1(&c, &r);
+		ed25519_p1p1_to_p3(&d, &c);
+		ed25519_madd_p1p1(&c, &d, &s);
+
+		if (i)
+			ed25519_p1p1_to_p2(&r, &c);
+		else
+			ed25519_p1p1_to_p3(r_out, &c);
+	}
+}
+
+void ed25519_window_init(struct ed25519_window *w,
+			 const struct ed25519_pt *p)
+{
+	struct ed25519_pt m[(1 << ED25519_WINDOW_BITS) - 1];
+	struct ed25519_pt_cached pc;
+	int i;
+
+	/* m[i] = (i + 1) p */
+	ed25519_copy(&m[0], p);
+	ed25519_to_cached(&pc, p);
+
+	for (i = 1; i < (1 << ED25519_WINDOW_BITS) - 1; i++) {
+		if (i & 1)
+			ed25519_double(&m[i], &m[i >> 1]);
+		else
+			ed25519_add_cached(&m[i], &m[i - 1], &pc);
+	}
+
+	memcpy(&w->p[0], &ed25519_neutral_niels, sizeof(w->p[0]));
+	ed25519_to_niels_batch(&w->p[1], m, (1 << ED25519_WINDOW_BITS) - 1);
+}
+
+void ed25519_smult_window(struct ed25519_pt *r_out,
+			  const struct ed25519_window *w,
+			  const uint8_t *e)
+{
+	uint8_t nibble[F25519_SIZE * 2];
+	struct ed25519_pt_niels s;
+	struct ed25519_pt_p1p1 c;
+	struct ed25519_pt_p2 r;
+	int i;
+
+	for (i = 0; i < F25519_SIZE * 2; i++) {
+		const int k = F25519_SIZE * 2 - 1 - i;
+
+		nibble[i] = (e[k >> 1] >> ((k & 1) << 2)) & 15;
+	}
+
+	if (ed25519_x4_smult_niels(r_out, w->p, 1 << ED25519_WINDOW_BITS,
+				   nibble, F25519_SIZE * 2,
+				   ED25519_WINDOW_BITS))
+		return;
+
+	/* Nibbles are taken most-significant first. The top one needs
+	 * no doublings, and no addition either: the affine point (x, y)
+	 * is (y+x - (y-x) : y+x + (y-x) : 2) in P2 form.
+	 */
+	niels_select(&s, w->p, 1 << ED25519_WINDOW_BITS, nibble[0]);
+	f25519_sub(r.x, s.ypx, s.ymx);
+	f25519_add(r.y, s.ypx, s.ymx);
+	f25519_load(r.z, 2);
+
+	for (i = F25519_SIZE * 2 - 2; i >= 0; i--) {
+		struct ed25519_pt d;
+		int j;
+
+		/* Only the last doubling needs T, for the addition */
+		for (j = 1; j < ED25519_WINDOW_BITS; j++) {
+			ed25519_double_p1p1(&c, &r);
+			ed25519_p1p1_to_p2(&r, &c);
+		}
+
+		ed25519_double_p1p1(&c, &r);
+		ed25519_p1p1_to_p3(&d, &c);
+
+		niels_select(&s, w->p, 1 << ED25519_WINDOW_BITS,
+			     nibble[F25519_SIZE * 2 - 1 - i]);
+		ed25519_madd_p1p1(&c, &d, &s);
+
+		if (i)
+			ed25519_p1p1_to_p2(&r, &c);
+		else
+			ed25519_p1p1_to_p3(r_out, &c);
+	}
 }
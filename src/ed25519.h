@@ -39,6 +39,9 @@ struct ed25519_pt {
 extern const struct ed25519_pt ed25519_base;
 extern const struct ed25519_pt ed25519_neutral;
 
+/* k = 2d, the curve constant of the addition formulas */
+extern const uint8_t ed25519_k[F25519_SIZE];
+
 /* Convert between projective and affine coordinates (x/y in F25519) */
 void ed25519_project(struct ed25519_pt *p,
 		     const uint8_t *x, const uint8_t *y);
@@ -73,10 +76,178 @@ static inline void ed25519_copy(struct ed25519_pt *dst,
 	memcpy(dst, src, sizeof(*dst));
 }
 
+/* Constant-time conditional swap of two points. If condition == 1, a
+ * and b are exchanged; if zero, neither is changed.
+ */
+static inline void ed25519_pt_cswap(struct ed25519_pt *a,
+				    struct ed25519_pt *b, uint8_t condition)
+{
+	f25519_cswap_n(a, b, sizeof(*a), condition);
+}
+
 void ed25519_add(struct ed25519_pt *r,
 		 const struct ed25519_pt *a, const struct ed25519_pt *b);
 void ed25519_double(struct ed25519_pt *r, const struct ed25519_pt *a);
+
+/* Intermediate representations, as used by the ref10 implementation.
+ * The extended coordinates of struct ed25519_pt ("P3") are needed only
+ * by the first operand of an addition. A point which will only be
+ * doubled can be kept in projective form (X : Y : Z), without T ("P2").
+ * Additions and doublings produce a "completed" point ("P1P1"), with
+ * x = X/Z and y = Y/T, which costs three multiplications to convert to
+ * P2 and four to P3.
+ *
+ * The coordinates of a P1P1 point may be relaxed field elements (see
+ * f25519.h): they are only ever multiplied, so their final carry pass
+ * is skipped. This is done only for sums of products. Sums of input
+ * coordinates are fully reduced, because points built by the caller
+ * may hold any 256-bit values there.
+ *
+ * ed25519_add() and ed25519_double() are each the corresponding _p1p1
+ * function, followed by conversion to P3.
+ */
+struct ed25519_pt_p2 {
+	uint8_t  x[F25519_SIZE];
+	uint8_t  y[F25519_SIZE];
+	uint8_t  z[F25519_SIZE];
+};
+
+struct ed25519_pt_p1p1 {
+	uint8_t  x[F25519_SIZE];
+	uint8_t  y[F25519_SIZE];
+	uint8_t  z[F25519_SIZE];
+	uint8_t  t[F25519_SIZE];
+};
+
+extern const struct ed25519_pt_p2 ed25519_neutral_p2;
+
+void ed25519_p1p1_to_p2(struct ed25519_pt_p2 *r,
+			const struct ed25519_pt_p1p1 *p);
+void ed25519_p1p1_to_p3(struct ed25519_pt *r,
+			const struct ed25519_pt_p1p1 *p);
+void ed25519_p3_to_p2(struct ed25519_pt_p2 *r, const struct ed25519_pt *p);
+
+void ed25519_double_p1p1(struct ed25519_pt_p1p1 *r,
+			 const struct ed25519_pt_p2 *p);
+
+/* A point which is to be added many times can be converted first to a
+ * "cached" form, holding the values which the addition formula derives
+ * from its second operand. ed25519_add() is equivalent to conversion
+ * followed by ed25519_add_cached(), but a cached point can be reused,
+ * saving a multiplication and four additions/subtractions each time.
+ */
+struct ed25519_pt_cached {
+	uint8_t  ypx[F25519_SIZE];	/* Y + X */
+	uint8_t  ymx[F25519_SIZE];	/* Y - X */
+	uint8_t  t2d[F25519_SIZE];	/* 2dT */
+	uint8_t  z2[F25519_SIZE];	/* 2Z */
+};
+
+extern const struct ed25519_pt_cached ed25519_neutral_cached;
+
+void ed25519_to_cached(struct ed25519_pt_cached *r,
+		       const struct ed25519_pt *p);
+void ed25519_add_cached(struct ed25519_pt *r, const struct ed25519_pt *a,
+			const struct ed25519_pt_cached *b);
+void ed25519_add_cached_p1p1(struct ed25519_pt_p1p1 *r,
+			     const struct ed25519_pt *a,
+			     const struct ed25519_pt_cached *b);
+
+/* Points with Z = 1 can be stored in the smaller "Niels" form, which
+ * also saves a multiplication on each addition (a "mixed" addition).
+ * This suits tables of points which are fixed in advance.
+ */
+struct ed25519_pt_niels {
+	uint8_t  ypx[F25519_SIZE];	/* y + x */
+	uint8_t  ymx[F25519_SIZE];	/* y - x */
+	uint8_t  xy2d[F25519_SIZE];	/* 2dxy */
+};
+
+extern const struct ed25519_pt_niels ed25519_neutral_niels;
+
+void ed25519_madd(struct ed25519_pt *r, const struct ed25519_pt *a,
+		  const struct ed25519_pt_niels *b);
+void ed25519_madd_p1p1(struct ed25519_pt_p1p1 *r,
+		       const struct ed25519_pt *a,
+		       const struct ed25519_pt_niels *b);
+
+/* Convert an array of points to Niels form. Normalization requires
+ * dividing by Z, so the inversions are shared by Montgomery's trick:
+ * one inversion in total, and three multiplications per point. No point
+ * may have Z = 0.
+ */
+void ed25519_to_niels_batch(struct ed25519_pt_niels *r,
+			    const struct ed25519_pt *p, unsigned int count);
+
 void ed25519_smult(struct ed25519_pt *r, const struct ed25519_pt *a,
 		   const uint8_t *e);
 
+/* Variable-time scalar multiplication, using a width-5 non-adjacent
+ * form of the exponent and a table of odd multiples. The result is the
+ * same as for ed25519_smult(), but the running time and memory access
+ * pattern depend on both the point and the exponent.
+ *
+ * WARNING: use this only where both inputs are public, as in signature
+ * verification. Never pass a secret exponent.
+ */
+void ed25519_smult_vartime(struct ed25519_pt *r, const struct ed25519_pt *a,
+			   const uint8_t *e);
+
+/* Multiply the base point by an exponent. The result is the same as
+ * ed25519_smult(r, &ed25519_base, e), but is computed using a
+ * precomputed table, with a quarter of the doublings and additions.
+ */
+void ed25519_smult_base(struct ed25519_pt *r, const uint8_t *e);
+
+/* Fixed-window scalar multiplication, for points which are multiplied
+ * repeatedly. The table holds the multiples 0..15 of a point in Niels
+ * form, and costs 14 point operations and a batch normalization to
+ * build. Each multiplication then needs 252 doublings and 63 mixed
+ * additions, rather than 256 doublings and additions. Lookups are
+ * constant-time.
+ */
+#define ED25519_WINDOW_BITS  4
+
+struct ed25519_window {
+	struct ed25519_pt_niels  p[1 << ED25519_WINDOW_BITS];
+};
+
+void ed25519_window_init(struct ed25519_window *w,
+			 const struct ed25519_pt *p);
+void ed25519_smult_window(struct ed25519_pt *r,
+			  const struct ed25519_window *w,
+			  const uint8_t *e);
+
+/* 4-way parallel backend (ed25519_x4.c). The HWCD formulas consist of
+ * two rounds of four independent multiplications, which are done
+ * together in the lanes of AVX2 registers. ed25519_smult(),
+ * ed25519_smult_base(), ed25519_smult_window() and
+ * ed25519_smult_vartime() use it automatically when the CPU supports
+ * it.
+ *
+ * The functions below return non-zero if they computed the result, or
+ * zero if the backend is unavailable, in which case the caller must
+ * use the byte-oriented code.
+ */
+int ed25519_x4_native(void);
+
+int ed25519_x4_smult(struct ed25519_pt *r, const struct ed25519_pt *p,
+		     const uint8_t *e);
+
+/* Variable-time: compute sum(naf[i] 2^i) p, where each digit is zero
+ * or odd and less than 16 in magnitude.
+ */
+int ed25519_x4_smult_wnaf(struct ed25519_pt *r, const struct ed25519_pt *p,
+			  const int8_t *naf, unsigned int len);
+
+/* Starting from the neutral point, for each i < count: double the
+ * accumulator the given number of times (except when i = 0), then add
+ * table[idx[i]]. The table may have at most 16 entries, and lookups
+ * are constant-time.
+ */
+int ed25519_x4_smult_niels(struct ed25519_pt *r,
+			   const struct ed25519_pt_niels *table,
+			   unsigned int size, const uint8_t *idx,
+			   unsigned int count, unsigned int doublings);
+
 #endif
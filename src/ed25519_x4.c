@@ -0,0 +1,380 @@
+/* Edwards curve point arithmetic, four multiplications at a time
+ *
+ * This file is in the public domain.
+ */
+
+#include "ed25519.h"
+#include "cpu.h"
+#include "fe4.h"
+
+#ifdef FE4_AVX2
+
+/* A point is held in a single vector element, whose lanes are
+ * (X, Y, Z, T). The HWCD formulas for addition and doubling each split
+ * into two rounds of four independent multiplications, so that each
+ * round is one fe4_mul() (Hisil et al., Section 4). Lane shuffles
+ * between rounds are cheap by comparison.
+ *
+ * Addends are held as (Y-X, Y+X, 2dT, 2Z), or as (y-x, y+x, 2dxy, 2)
+ * for a Niels point, so that the first round of an addition is a
+ * single lane-wise product.
+ */
+struct ed25519_pt_x4 {
+	struct fe4	v;
+};
+
+/* Immediate for _mm256_permute4x64_epi64(): lane i of the result is
+ * taken from lane i of the argument list.
+ */
+#define LANES(a, b, c, d)  ((a) | ((b) << 2) | ((c) << 4) | ((d) << 6))
+
+/* Immediates for _mm256_blend_epi32(), selecting 64-bit lanes */
+#define BLEND_0    0x03
+#define BLEND_1    0x0c
+#define BLEND_2    0x30
+#define BLEND_23   0xf0
+#define BLEND_13   0xcc
+
+static AVX2 void load4(struct fe4 *r, const uint8_t *a, const uint8_t *b,
+		       const uint8_t *c, const uint8_t *d)
+{
+	uint8_t buf[4 * F25519_SIZE];
+
+	f25519_copy(buf, a);
+	f25519_copy(buf + F25519_SIZE, b);
+	f25519_copy(buf + F25519_SIZE * 2, c);
+	f25519_copy(buf + F25519_SIZE * 3, d);
+
+	fe4_load(r, buf);
+	fe4_carry(r);
+}
+
+static AVX2 void pt4_load(struct ed25519_pt_x4 *r, const struct ed25519_pt *p)
+{
+	load4(&r->v, p->x, p->y, p->z, p->t);
+}
+
+static AVX2 void pt4_store(struct ed25519_pt *r, const struct ed25519_pt_x4 *p)
+{
+	uint8_t buf[4 * F25519_SIZE];
+
+	fe4_store(buf, &p->v);
+
+	f25519_copy(r->x, buf);
+	f25519_copy(r->y, buf + F25519_SIZE);
+	f25519_copy(r->z, buf + F25519_SIZE * 2);
+	f25519_copy(r->t, buf + F25519_SIZE * 3);
+}
+
+static AVX2 void pt4_from_niels(struct ed25519_pt_x4 *r,
+				const struct ed25519_pt_niels *p)
+{
+	static const uint8_t two[F25519_SIZE] = {2};
+
+	load4(&r->v, p->ymx, p->ypx, p->xy2d, two);
+}
+
+/* Given the lanes (X, Y, Z, T), compute (Y-X, Y+X, T, Z) */
+static AVX2 void pt4_prepare(struct fe4 *r, const struct fe4 *p)
+{
+	int i;
+
+	for (i = 0; i < FE4_LIMBS; i++) {
+		const __m256i v = p->l[i];
+		const __m256i x = _mm256_permute4x64_epi64(v, LANES(0, 0, 0, 0));
+		const __m256i y = _mm256_permute4x64_epi64(v, LANES(1, 1, 1, 1));
+		const __m256i tz = _mm256_permute4x64_epi64(v, LANES(0, 0, 3, 2));
+		const __m256i d = _mm256_sub_epi64(_mm256_add_epi64(y,
+				_mm256_set1_epi64x(two_p[i])), x);
+
+		r->l[i] = _mm256_blend_epi32(
+			_mm256_blend_epi32(d, _mm256_add_epi64(y, x), BLEND_1),
+			tz, BLEND_23);
+	}
+}
+
+/* Convert a point to an addend: (Y-X, Y+X, 2dT, 2Z) */
+static AVX2 void pt4_cached(struct ed25519_pt_x4 *r,
+			    const struct ed25519_pt_x4 *p)
+{
+	static const uint8_t one[F25519_SIZE] = {1};
+	static const uint8_t two[F25519_SIZE] = {2};
+	struct fe4 k;
+
+	load4(&k, one, one, ed25519_k, two);
+	pt4_prepare(&r->v, &p->v);
+	fe4_mul(&r->v, &r->v, &k);
+}
+
+/* Second round, shared by addition and doubling. Given the lanes
+ * (E, H, F, G), compute (X3, Y3, Z3, T3) = (E F, G H, F G, E H).
+ */
+static AVX2 void pt4_finish(struct ed25519_pt_x4 *r, const struct fe4 *ehfg)
+{
+	struct fe4 m1, m2;
+	int i;
+
+	for (i = 0; i < FE4_LIMBS; i++) {
+		m1.l[i] = _mm256_permute4x64_epi64(ehfg->l[i],
+						   LANES(0, 3, 2, 0));
+		m2.l[i] = _mm256_permute4x64_epi64(ehfg->l[i],
+						   LANES(2, 1, 3, 1));
+	}
+
+	fe4_mul(&r->v, &m1, &m2);
+}
+
+static AVX2 void pt4_add(struct ed25519_pt_x4 *r,
+			 const struct ed25519_pt_x4 *p,
+			 const struct ed25519_pt_x4 *q)
+{
+	/* add-2008-hwcd-3, as in ed25519_add_cached_p1p1() */
+	struct fe4 t;
+	int i;
+
+	/* (A, B, C, D) */
+	pt4_prepare(&t, &p->v);
+	fe4_mul(&t, &t, &q->v);
+
+	/* (E, H, F, G) = (B-A, B+A, D-C, D+C) */
+	for (i = 0; i < FE4_LIMBS; i++) {
+		const __m256i v = t.l[i];
+		const __m256i s = _mm256_permute4x64_epi64(v, LANES(1, 0, 3, 2));
+		const __m256i d = _mm256_sub_epi64(_mm256_add_epi64(s,
+				_mm256_set1_epi64x(two_p[i])), v);
+
+		t.l[i] = _mm256_blend_epi32(d, _mm256_add_epi64(v, s),
+					    BLEND_13);
+	}
+
+	pt4_finish(r, &t);
+}
+
+static AVX2 void pt4_double(struct ed25519_pt_x4 *r,
+			    const struct ed25519_pt_x4 *p)
+{
+	/* dbl-2008-hwcd, as in ed25519_double_p1p1() */
+	const __m256i zero = _mm256_setzero_si256();
+	struct fe4 t;
+	int i;
+
+	/* (X1, Y1, Z1, X1+Y1) */
+	for (i = 0; i < FE4_LIMBS; i++) {
+		const __m256i v = p->v.l[i];
+
+		t.l[i] = _mm256_add_epi64(
+			_mm256_permute4x64_epi64(v, LANES(0, 1, 2, 0)),
+			_mm256_blend_epi32(zero,
+				_mm256_permute4x64_epi64(v, LANES(1, 1, 1, 1)),
+				0xc0));
+	}
+
+	/* (A, B, Z1^2, (X1+Y1)^2) */
+	fe4_mul(&t, &t, &t);
+
+	/* With S = (X1+Y1)^2, we have E = S-A-B, H = -A-B, F = B-A-2Z1^2
+	 * and G = B-A. Negating all four leaves the result unchanged, so
+	 * compute (-E, -H, -F, -G) = (A+B-S, A+B, A-B+2Z1^2, A-B).
+	 */
+	for (i = 0; i < FE4_LIMBS; i++) {
+		const __m256i v = t.l[i];
+		const __m256i tp = _mm256_set1_epi64x(two_p[i]);
+		const __m256i a = _mm256_permute4x64_epi64(v, LANES(0, 0, 0, 0));
+		const __m256i b = _mm256_permute4x64_epi64(v, LANES(1, 1, 1, 1));
+		const __m256i z = _mm256_permute4x64_epi64(v, LANES(2, 2, 2, 2));
+		const __m256i s = _mm256_permute4x64_epi64(v, LANES(3, 3, 3, 3));
+		const __m256i ab = _mm256_blend_epi32(_mm256_add_epi64(a, b),
+			_mm256_sub_epi64(_mm256_add_epi64(a, tp), b),
+			BLEND_23);
+		const __m256i extra = _mm256_blend_epi32(
+			_mm256_blend_epi32(_mm256_add_epi64(z, z),
+					   _mm256_sub_epi64(tp, s), BLEND_0),
+			zero, BLEND_13);
+
+		t.l[i] = _mm256_add_epi64(ab, extra);
+	}
+
+	fe4_carry(&t);
+	pt4_finish(r, &t);
+}
+
+static AVX2 void smult_avx2(struct ed25519_pt *r_out,
+			    const struct ed25519_pt *p, const uint8_t *e)
+{
+	struct ed25519_pt_x4 r;
+	struct ed25519_pt_x4 pc;
+	int i;
+
+	pt4_load(&r, p);
+	pt4_cached(&pc, &r);
+	pt4_load(&r, &ed25519_neutral);
+
+	for (i = 255; i >= 0; i--) {
+		const uint8_t bit = (e[i >> 3] >> (i & 7)) & 1;
+		struct ed25519_pt_x4 s;
+
+		pt4_double(&r, &r);
+		pt4_add(&s, &r, &pc);
+		fe4_cmov(&r.v, &s.v, _mm256_set1_epi64x(-(int64_t)bit));
+	}
+
+	pt4_store(r_out, &r);
+}
+
+static AVX2 void smult_niels_avx2(struct ed25519_pt *r_out,
+				  const struct ed25519_pt_niels *table,
+				  unsigned int size, const uint8_t *idx,
+				  unsigned int count, unsigned int doublings)
+{
+	struct ed25519_pt_x4 t[16];
+	struct ed25519_pt_x4 r;
+	unsigned int i;
+
+	for (i = 0; i < size; i++)
+		pt4_from_niels(&t[i], &table[i]);
+
+	pt4_load(&r, &ed25519_neutral);
+
+	for (i = 0; i < count; i++) {
+		struct ed25519_pt_x4 s = t[0];
+		unsigned int j;
+
+		/* Every entry is read, regardless of idx[i] */
+		for (j = 1; j < size; j++) {
+			const uint32_t eq = (((uint32_t)(j ^ idx[i])) - 1) >> 31;
+
+			fe4_cmov(&s.v, &t[j].v, _mm256_set1_epi64x(-(int64_t)eq));
+		}
+
+		if (i)
+			for (j = 0; j < doublings; j++)
+				pt4_double(&r, &r);
+
+		pt4_add(&r, &r, &s);
+	}
+
+	pt4_store(r_out, &r);
+}
+
+static AVX2 void smult_wnaf_avx2(struct ed25519_pt *r_out,
+				 const struct ed25519_pt *p,
+				 const int8_t *naf, int len)
+{
+	struct ed25519_pt_x4 pos[8];
+	struct ed25519_pt_x4 neg[8];
+	struct ed25519_pt_x4 m;
+	struct ed25519_pt_x4 d;
+	struct ed25519_pt_x4 r;
+	int i;
+
+	/* pos[i] = (2i + 1) p */
+	pt4_load(&m, p);
+	pt4_cached(&pos[0], &m);
+	pt4_double(&d, &m);
+	pt4_cached(&d, &d);
+
+	for (i = 1; i < 8; i++) {
+		pt4_add(&m, &m, &d);
+		pt4_cached(&pos[i], &m);
+	}
+
+	/* neg[i] = -pos[i]: swap the first two lanes and negate the
+	 * third.
+	 */
+	for (i = 0; i < 8; i++) {
+		int j;
+
+		for (j = 0; j < FE4_LIMBS; j++) {
+			const __m256i v = _mm256_permute4x64_epi64(pos[i].v.l[j],
+							LANES(1, 0, 2, 3));
+
+			neg[i].v.l[j] = _mm256_blend_epi32(v,
+				_mm256_sub_epi64(_mm256_set1_epi64x(two_p[j]),
+						 v), BLEND_2);
+		}
+	}
+
+	while (len > 0 && !naf[len - 1])
+		len--;
+
+	pt4_load(&r, &ed25519_neutral);
+
+	for (i = len - 1; i >= 0; i--) {
+		pt4_double(&r, &r);
+
+		if (naf[i] > 0)
+			pt4_add(&r, &r, &pos[naf[i] >> 1]);
+		else if (naf[i] < 0)
+			pt4_add(&r, &r, &neg[(-naf[i]) >> 1]);
+	}
+
+	pt4_store(r_out, &r);
+}
+
+#endif /* FE4_AVX2 */
+
+int ed25519_x4_native(void)
+{
+#ifdef FE4_AVX2
+	return cpu_features() & CPU_AVX2;
+#else
+	return 0;
+#endif
+}
+
+int ed25519_x4_smult(struct ed25519_pt *r, const struct ed25519_pt *p,
+		     const uint8_t *e)
+{
+#ifdef FE4_AVX2
+	if (ed25519_x4_native()) {
+		smult_avx2(r, p, e);
+		return 1;
+	}
+#else
+	(void)r;
+	(void)p;
+	(void)e;
+#endif
+
+	return 0;
+}
+
+int ed25519_x4_smult_wnaf(struct ed25519_pt *r, const struct ed25519_pt *p,
+			  const int8_t *naf, unsigned int len)
+{
+#ifdef FE4_AVX2
+	if (ed25519_x4_native()) {
+		smult_wnaf_avx2(r, p, naf, len);
+		return 1;
+	}
+#else
+	(void)r;
+	(void)p;
+	(void)naf;
+	(void)len;
+#endif
+
+	return 0;
+}
+
+int ed25519_x4_smult_niels(struct ed25519_pt *r,
+			   const struct ed25519_pt_niels *table,
+			   unsigned int size, const uint8_t *idx,
+			   unsigned int count, unsigned int doublings)
+{
+#ifdef FE4_AVX2
+	if (ed25519_x4_native() && size <= 16) {
+		smult_niels_avx2(r, table, size, idx, count, doublings);
+		return 1;
+	}
+#else
+	(void)r;
+	(void)table;
+	(void)size;
+	(void)idx;
+	(void)count;
+	(void)doublings;
+#endif
+
+	return 0;
+}
@@ -6,18 +6,11 @@
 
 #include "ed25519.h"
 #include "sha512.h"
-#include "fprime.h"
+#include "sc25519.h"
 #include "edsign.h"
 
 #define EXPANDED_SIZE  64
 
-static const uint8_t ed25519_order[FPRIME_SIZE] = {
-	0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
-	0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
-};
-
 static void expand_key(uint8_t *expanded, const uint8_t *secret)
 {
 	struct sha512_state s;
@@ -90,7 +83,7 @@ static void hash_with_prefix(uint8_t *out_fp,
 	}
 
 	sha512_get(&s, init_block, 0, SHA512_HASH_SIZE);
-	fprime_from_bytes(out_fp, init_block, SHA512_HASH_SIZE, ed25519_order);
+	sc25519_from_bytes(out_fp, init_block, SHA512_HASH_SIZE);
 }
 
 static void generate_k(uint8_t *k, const uint8_t *kgen_key,
@@ -117,10 +110,10 @@ void edsign_sign(uint8_t *signature, const uint8_t *pub,
 		 const uint8_t *message, size_t len)
 {
 	uint8_t expanded[EXPANDED_SIZE];
-	uint8_t e[FPRIME_SIZE];
-	uint8_t s[FPRIME_SIZE];
-	uint8_t k[FPRIME_SIZE];
-	uint8_t z[FPRIME_SIZE];
+	uint8_t e[SC25519_SIZE];
+	uint8_t s[SC25519_SIZE];
+	uint8_t k[SC25519_SIZE];
+	uint8_t z[SC25519_SIZE];
 
 	expand_key(expanded, secret);
 
@@ -132,11 +125,10 @@ void edsign_sign(uint8_t *signature, const uint8_t *pub,
 	hash_message(z, signature, pub, message, len);
 
 	/* Obtain e */
-	fprime_from_bytes(e, expanded, 32, ed25519_order);
+	sc25519_from_bytes(e, expanded, 32);
 
 	/* Compute s = ze + k */
-	fprime_mul(s, z, e, ed25519_order);
-	fprime_add(s, k, ed25519_order);
+	sc25519_muladd(s, z, e, k);
 	memcpy(signature + 32, s, 32);
 }
 
@@ -147,7 +139,7 @@ uint8_t edsign_verify(const uint8_t *signature, const uint8_t *pub,
 	struct ed25519_pt q;
 	uint8_t lhs[F25519_SIZE];
 	uint8_t rhs[F25519_SIZE];
-	uint8_t z[FPRIME_SIZE];
+	uint8_t z[SC25519_SIZE];
 	uint8_t ok = 1;
 
 	/* Compute z = H(R, A, M) */
@@ -158,7 +150,7 @@ uint8_t edsign_verify(const uint8_t *signature, const uint8_t *pub,
 
 	/* ... = zA + R */
 	ok &= upp(&p, pub);
-	ed25519_smult(&p, &p, z);
+	ed25519_smult_vartime(&p, &p, z);
 	ok &= upp(&q, signature);
 	ed25519_add(&p, &p, &q);
 	pp(rhs, &p);
@@ -5,6 +5,9 @@
  */
 
 #include "f25519.h"
+#include "modinv.h"
+#include "cpu.h"
+#include "opcount.h"
 
 const uint8_t f25519_zero[F25519_SIZE] = {0};
 const uint8_t f25519_one[F25519_SIZE] = {1};
@@ -83,11 +86,84 @@ void f25519_select(uint8_t *dst,
 		dst[i] = zero[i] ^ (mask & (one[i] ^ zero[i]));
 }
 
+/* Masked operations work a word at a time, with any tail done byte by
+ * byte. The mask is either all zeros or all ones.
+ */
+static void cswap_words(uint8_t *a, uint8_t *b, size_t size, uint64_t mask)
+{
+	size_t i;
+
+	for (i = 0; i + 8 <= size; i += 8) {
+		uint64_t wa, wb, t;
+
+		memcpy(&wa, a + i, 8);
+		memcpy(&wb, b + i, 8);
+		t = mask & (wa ^ wb);
+		wa ^= t;
+		wb ^= t;
+		memcpy(a + i, &wa, 8);
+		memcpy(b + i, &wb, 8);
+	}
+
+	for (; i < size; i++) {
+		const uint8_t t = mask & (a[i] ^ b[i]);
+
+		a[i] ^= t;
+		b[i] ^= t;
+	}
+}
+
+static void cmov_words(uint8_t *dst, const uint8_t *src, size_t size,
+		       uint64_t mask)
+{
+	size_t i;
+
+	for (i = 0; i + 8 <= size; i += 8) {
+		uint64_t wd, ws;
+
+		memcpy(&wd, dst + i, 8);
+		memcpy(&ws, src + i, 8);
+		wd ^= mask & (wd ^ ws);
+		memcpy(dst + i, &wd, 8);
+	}
+
+	for (; i < size; i++)
+		dst[i] ^= mask & (dst[i] ^ src[i]);
+}
+
+void f25519_cswap(uint8_t *a, uint8_t *b, uint8_t condition)
+{
+	cswap_words(a, b, F25519_SIZE, -(uint64_t)condition);
+}
+
+void f25519_cswap_n(void *a, void *b, size_t size, uint8_t condition)
+{
+	cswap_words(a, b, size, -(uint64_t)condition);
+}
+
+void f25519_lookup(void *dst, const void *table, size_t size,
+		   unsigned int count, unsigned int idx)
+{
+	const uint8_t *t = table;
+	unsigned int j;
+
+	memset(dst, 0, size);
+
+	for (j = 0; j < count; j++) {
+		/* All ones if j == idx, computed without a branch */
+		const uint64_t eq = -(((uint64_t)(j ^ idx) - 1) >> 63);
+
+		cmov_words(dst, t + j * size, size, eq);
+	}
+}
+
 void f25519_add(uint8_t *r, const uint8_t *a, const uint8_t *b)
 {
 	uint16_t c = 0;
 	int i;
 
+	OPCOUNT(f25519_add);
+
 	/* Add */
 	for (i = 0; i < F25519_SIZE; i++) {
 		c >>= 8;
@@ -106,11 +182,35 @@ void f25519_add(uint8_t *r, const uint8_t *a, const uint8_t *b)
 	}
 }
 
+void f25519_add__lazy(uint8_t *r, const uint8_t *a, const uint8_t *b)
+{
+	/* Fold bit 255 of each input in first, using 2^255 = 19 mod p.
+	 * For x < 2p, the low 255 bits plus 19 times bit 255 are at most
+	 * 2^255 - 20, and for any x they are at most 2^255 + 18. So if
+	 * either input is below 2p, the sum is less than 2^256 and the
+	 * final carry pass can be skipped.
+	 */
+	uint16_t c = ((a[31] >> 7) + (b[31] >> 7)) * 19;
+	int i;
+
+	OPCOUNT(f25519_add_lazy);
+
+	for (i = 0; i + 1 < F25519_SIZE; i++) {
+		c += ((uint16_t)a[i]) + ((uint16_t)b[i]);
+		r[i] = c;
+		c >>= 8;
+	}
+
+	r[31] = c + (a[31] & 127) + (b[31] & 127);
+}
+
 void f25519_sub(uint8_t *r, const uint8_t *a, const uint8_t *b)
 {
 	uint32_t c = 0;
 	int i;
 
+	OPCOUNT(f25519_sub);
+
 	/* Calculate a + 2p - b, to avoid underflow */
 	c = 218;
 	for (i = 0; i + 1 < F25519_SIZE; i++) {
@@ -135,6 +235,8 @@ void f25519_neg(uint8_t *r, const uint8_t *a)
 	uint32_t c = 0;
 	int i;
 
+	OPCOUNT(f25519_neg);
+
 	/* Calculate 2p - a, to avoid underflow */
 	c = 218;
 	for (i = 0; i + 1 < F25519_SIZE; i++) {
@@ -154,7 +256,7 @@ void f25519_neg(uint8_t *r, const uint8_t *a)
 	}
 }
 
-void f25519_mul__distinct(uint8_t *r, const uint8_t *a, const uint8_t *b)
+static void mul_portable(uint8_t *r, const uint8_t *a, const uint8_t *b)
 {
 	uint32_t c = 0;
 	int i;
@@ -183,6 +285,413 @@ void f25519_mul__distinct(uint8_t *r, const uint8_t *a, const uint8_t *b)
 	}
 }
 
+#if defined(__SIZEOF_INT128__) || (defined(__GNUC__) && defined(__x86_64__))
+static uint64_t load64(const uint8_t *x)
+{
+	uint64_t r = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	memcpy(&r, x, sizeof(r));
+#else
+	int i;
+
+	for (i = 7; i >= 0; i--)
+		r = (r << 8) | x[i];
+#endif
+
+	return r;
+}
+
+static void store64(uint8_t *x, uint64_t v)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	memcpy(x, &v, sizeof(v));
+#else
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		x[i] = v;
+		v >>= 8;
+	}
+#endif
+}
+#endif
+
+#ifdef __SIZEOF_INT128__
+#define F25519_RADIX51
+
+__extension__ typedef unsigned __int128 u128;
+
+/* Five limbs of 51 bits. The top limb also takes bit 255. */
+static void unpack51(uint64_t *f, const uint8_t *x)
+{
+	const uint64_t mask = (((uint64_t)1) << 51) - 1;
+	const uint64_t w0 = load64(x);
+	const uint64_t w1 = load64(x + 8);
+	const uint64_t w2 = load64(x + 16);
+	const uint64_t w3 = load64(x + 24);
+
+	f[0] = w0 & mask;
+	f[1] = ((w0 >> 51) | (w1 << 13)) & mask;
+	f[2] = ((w1 >> 38) | (w2 << 26)) & mask;
+	f[3] = ((w2 >> 25) | (w3 << 39)) & mask;
+	f[4] = w3 >> 12;
+}
+
+/* Limbs must be below 2^51, except the top, which may be 2^51. The
+ * result is then less than 2^255 + 2^204 < 2p.
+ */
+static void pack51(uint8_t *x, const uint64_t *f)
+{
+	store64(x, f[0] | (f[1] << 51));
+	store64(x + 8, (f[1] >> 13) | (f[2] << 38));
+	store64(x + 16, (f[2] >> 26) | (f[3] << 25));
+	store64(x + 24, (f[3] >> 39) | (f[4] << 12));
+}
+
+static void mul_radix51(uint8_t *r, const uint8_t *a, const uint8_t *b)
+{
+	const uint64_t mask = (((uint64_t)1) << 51) - 1;
+	uint64_t f[5], g[5], g19[5];
+	uint64_t h[5];
+	u128 t[5];
+	uint64_t c;
+	int i;
+
+	unpack51(f, a);
+	unpack51(g, b);
+
+	for (i = 1; i < 5; i++)
+		g19[i] = g[i] * 19;
+
+	/* Products wrapping past 2^255 are multiplied by 19 */
+	t[0] = (u128)f[0] * g[0] + (u128)f[1] * g19[4] +
+		(u128)f[2] * g19[3] + (u128)f[3] * g19[2] +
+		(u128)f[4] * g19[1];
+	t[1] = (u128)f[0] * g[1] + (u128)f[1] * g[0] +
+		(u128)f[2] * g19[4] + (u128)f[3] * g19[3] +
+		(u128)f[4] * g19[2];
+	t[2] = (u128)f[0] * g[2] + (u128)f[1] * g[1] +
+		(u128)f[2] * g[0] + (u128)f[3] * g19[4] +
+		(u128)f[4] * g19[3];
+	t[3] = (u128)f[0] * g[3] + (u128)f[1] * g[2] +
+		(u128)f[2] * g[1] + (u128)f[3] * g[0] +
+		(u128)f[4] * g19[4];
+	t[4] = (u128)f[0] * g[4] + (u128)f[1] * g[3] +
+		(u128)f[2] * g[2] + (u128)f[3] * g[1] +
+		(u128)f[4] * g[0];
+
+	for (i = 0; i < 4; i++) {
+		t[i + 1] += t[i] >> 51;
+		h[i] = (uint64_t)t[i] & mask;
+	}
+
+	c = (uint64_t)(t[4] >> 51);
+	h[4] = (uint64_t)t[4] & mask;
+
+	/* c < 2^64 / 19, so this doesn't overflow */
+	t[0] = (u128)c * 19 + h[0];
+	h[0] = (uint64_t)t[0] & mask;
+	c = (uint64_t)(t[0] >> 51);
+
+	for (i = 1; i < 5; i++) {
+		h[i] += c;
+		c = h[i] >> 51;
+		if (i < 4)
+			h[i] &= mask;
+	}
+
+	pack51(r, h);
+}
+#endif /* __SIZEOF_INT128__ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define F25519_MULX
+
+/* Four 64-bit limbs, with the MULX/ADCX/ADOX instructions. Within each
+ * row of partial products, the low halves are accumulated on the carry
+ * flag chain and the high halves on the overflow flag chain, so that
+ * the two chains run interleaved. Compilers don't reliably generate
+ * this from intrinsics, so it is written out.
+ */
+
+/* t[0..7] = a * b */
+static void mulx_mul(uint64_t *t, const uint64_t *a, const uint64_t *b)
+{
+	__asm__ volatile(
+		/* Row 0: t[0..4] in r8..r12 */
+		"movq 0(%[b]), %%rdx\n\t"
+		"mulxq 0(%[a]), %%r8, %%r9\n\t"
+		"mulxq 8(%[a]), %%rax, %%r10\n\t"
+		"addq %%rax, %%r9\n\t"
+		"mulxq 16(%[a]), %%rax, %%r11\n\t"
+		"adcq %%rax, %%r10\n\t"
+		"mulxq 24(%[a]), %%rax, %%r12\n\t"
+		"adcq %%rax, %%r11\n\t"
+		"adcq $0, %%r12\n\t"
+		"movq %%r8, 0(%[t])\n\t"
+
+		/* Row 1: t[1..5] in r9..r12, r8 */
+		"movq 8(%[b]), %%rdx\n\t"
+		"xorl %%r8d, %%r8d\n\t"
+		"mulxq 0(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r9\n\t"
+		"adoxq %%r13, %%r10\n\t"
+		"mulxq 8(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r10\n\t"
+		"adoxq %%r13, %%r11\n\t"
+		"mulxq 16(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r11\n\t"
+		"adoxq %%r13, %%r12\n\t"
+		"mulxq 24(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r12\n\t"
+		"adoxq %%r13, %%r8\n\t"
+		"movl $0, %%eax\n\t"
+		"adcxq %%rax, %%r8\n\t"
+		"movq %%r9, 8(%[t])\n\t"
+
+		/* Row 2: t[2..6] in r10..r12, r8, r9 */
+		"movq 16(%[b]), %%rdx\n\t"
+		"xorl %%r9d, %%r9d\n\t"
+		"mulxq 0(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r10\n\t"
+		"adoxq %%r13, %%r11\n\t"
+		"mulxq 8(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r11\n\t"
+		"adoxq %%r13, %%r12\n\t"
+		"mulxq 16(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r12\n\t"
+		"adoxq %%r13, %%r8\n\t"
+		"mulxq 24(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r8\n\t"
+		"adoxq %%r13, %%r9\n\t"
+		"movl $0, %%eax\n\t"
+		"adcxq %%rax, %%r9\n\t"
+		"movq %%r10, 16(%[t])\n\t"
+
+		/* Row 3: t[3..7] in r11, r12, r8..r10 */
+		"movq 24(%[b]), %%rdx\n\t"
+		"xorl %%r10d, %%r10d\n\t"
+		"mulxq 0(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r11\n\t"
+		"adoxq %%r13, %%r12\n\t"
+		"mulxq 8(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r12\n\t"
+		"adoxq %%r13, %%r8\n\t"
+		"mulxq 16(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r8\n\t"
+		"adoxq %%r13, %%r9\n\t"
+		"mulxq 24(%[a]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r9\n\t"
+		"adoxq %%r13, %%r10\n\t"
+		"movl $0, %%eax\n\t"
+		"adcxq %%rax, %%r10\n\t"
+		"movq %%r11, 24(%[t])\n\t"
+		"movq %%r12, 32(%[t])\n\t"
+		"movq %%r8, 40(%[t])\n\t"
+		"movq %%r9, 48(%[t])\n\t"
+		"movq %%r10, 56(%[t])\n\t"
+		:
+		: [t] "r"(t), [a] "r"(a), [b] "r"(b)
+		: "rax", "rdx", "r8", "r9", "r10", "r11", "r12", "r13",
+		  "cc", "memory");
+}
+
+/* t[0..7] = a^2, with six cross products and four squares */
+static void mulx_sqr(uint64_t *t, const uint64_t *a)
+{
+	__asm__ volatile(
+		/* Cross products a[i] a[j], i < j, into r9..r14 */
+		"movq 0(%[a]), %%rdx\n\t"
+		"mulxq 8(%[a]), %%r9, %%r10\n\t"
+		"mulxq 16(%[a]), %%rax, %%r11\n\t"
+		"addq %%rax, %%r10\n\t"
+		"mulxq 24(%[a]), %%rax, %%r12\n\t"
+		"adcq %%rax, %%r11\n\t"
+		"adcq $0, %%r12\n\t"
+
+		"movq 8(%[a]), %%rdx\n\t"
+		"xorl %%r13d, %%r13d\n\t"
+		"mulxq 16(%[a]), %%rax, %%r14\n\t"
+		"adcxq %%rax, %%r11\n\t"
+		"adoxq %%r14, %%r12\n\t"
+		"mulxq 24(%[a]), %%rax, %%r14\n\t"
+		"adcxq %%rax, %%r12\n\t"
+		"adoxq %%r14, %%r13\n\t"
+		"movl $0, %%eax\n\t"
+		"adcxq %%rax, %%r13\n\t"
+
+		"movq 16(%[a]), %%rdx\n\t"
+		"mulxq 24(%[a]), %%rax, %%r14\n\t"
+		"addq %%rax, %%r13\n\t"
+		"adcq $0, %%r14\n\t"
+
+		/* Double them, into r9..r15 */
+		"xorl %%r15d, %%r15d\n\t"
+		"addq %%r9, %%r9\n\t"
+		"adcq %%r10, %%r10\n\t"
+		"adcq %%r11, %%r11\n\t"
+		"adcq %%r12, %%r12\n\t"
+		"adcq %%r13, %%r13\n\t"
+		"adcq %%r14, %%r14\n\t"
+		"adcq %%r15, %%r15\n\t"
+
+		/* Add the squares a[i]^2 */
+		"movq 0(%[a]), %%rdx\n\t"
+		"mulxq %%rdx, %%r8, %%rax\n\t"
+		"addq %%rax, %%r9\n\t"
+		"movq 8(%[a]), %%rdx\n\t"
+		"mulxq %%rdx, %%rax, %%rcx\n\t"
+		"adcq %%rax, %%r10\n\t"
+		"adcq %%rcx, %%r11\n\t"
+		"movq 16(%[a]), %%rdx\n\t"
+		"mulxq %%rdx, %%rax, %%rcx\n\t"
+		"adcq %%rax, %%r12\n\t"
+		"adcq %%rcx, %%r13\n\t"
+		"movq 24(%[a]), %%rdx\n\t"
+		"mulxq %%rdx, %%rax, %%rcx\n\t"
+		"adcq %%rax, %%r14\n\t"
+		"adcq %%rcx, %%r15\n\t"
+
+		"movq %%r8, 0(%[t])\n\t"
+		"movq %%r9, 8(%[t])\n\t"
+		"movq %%r10, 16(%[t])\n\t"
+		"movq %%r11, 24(%[t])\n\t"
+		"movq %%r12, 32(%[t])\n\t"
+		"movq %%r13, 40(%[t])\n\t"
+		"movq %%r14, 48(%[t])\n\t"
+		"movq %%r15, 56(%[t])\n\t"
+		:
+		: [t] "r"(t), [a] "r"(a)
+		: "rax", "rcx", "rdx", "r8", "r9", "r10", "r11", "r12",
+		  "r13", "r14", "r15", "cc", "memory");
+}
+
+/* Reduce an eight-limb product using 2^256 = 38, and then bit 255
+ * using 2^255 = 19. The result is less than 2^255 + 2^12 < 2p.
+ */
+static void mulx_reduce(uint64_t *r, const uint64_t *t)
+{
+	__asm__ volatile(
+		"movl $38, %%edx\n\t"
+		"xorl %%r12d, %%r12d\n\t"
+		"movq 0(%[t]), %%r8\n\t"
+		"movq 8(%[t]), %%r9\n\t"
+		"movq 16(%[t]), %%r10\n\t"
+		"movq 24(%[t]), %%r11\n\t"
+		"mulxq 32(%[t]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r8\n\t"
+		"adoxq %%r13, %%r9\n\t"
+		"mulxq 40(%[t]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r9\n\t"
+		"adoxq %%r13, %%r10\n\t"
+		"mulxq 48(%[t]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r10\n\t"
+		"adoxq %%r13, %%r11\n\t"
+		"mulxq 56(%[t]), %%rax, %%r13\n\t"
+		"adcxq %%rax, %%r11\n\t"
+		"adoxq %%r13, %%r12\n\t"
+		"movl $0, %%eax\n\t"
+		"adcxq %%rax, %%r12\n\t"
+
+		/* Bits 255 and up, at most 2^7, times 19 */
+		"shldq $1, %%r11, %%r12\n\t"
+		"btrq $63, %%r11\n\t"
+		"imulq $19, %%r12, %%r12\n\t"
+		"addq %%r12, %%r8\n\t"
+		"adcq $0, %%r9\n\t"
+		"adcq $0, %%r10\n\t"
+		"adcq $0, %%r11\n\t"
+
+		"movq %%r8, 0(%[r])\n\t"
+		"movq %%r9, 8(%[r])\n\t"
+		"movq %%r10, 16(%[r])\n\t"
+		"movq %%r11, 24(%[r])\n\t"
+		:
+		: [r] "r"(r), [t] "r"(t)
+		: "rax", "rdx", "r8", "r9", "r10", "r11", "r12", "r13",
+		  "cc", "memory");
+}
+
+static void mul_mulx(uint8_t *r, const uint8_t *a, const uint8_t *b)
+{
+	uint64_t x[4], y[4];
+	uint64_t t[8];
+	int i;
+
+	for (i = 0; i < 4; i++)
+		x[i] = load64(a + i * 8);
+
+	/* Squarings need only ten products instead of sixteen */
+	if (a == b) {
+		mulx_sqr(t, x);
+	} else {
+		for (i = 0; i < 4; i++)
+			y[i] = load64(b + i * 8);
+
+		mulx_mul(t, x, y);
+	}
+
+	mulx_reduce(x, t);
+
+	for (i = 0; i < 4; i++)
+		store64(r + i * 8, x[i]);
+}
+#endif /* __GNUC__ && __x86_64__ */
+
+f25519_mul_fn f25519_mul_backend(const char *name)
+{
+	if (!strcmp(name, "portable"))
+		return mul_portable;
+
+#ifdef F25519_RADIX51
+	if (!strcmp(name, "radix51"))
+		return mul_radix51;
+#endif
+
+#ifdef F25519_MULX
+	if (!strcmp(name, "mulx") &&
+	    (cpu_features() & (CPU_BMI2 | CPU_ADX)) == (CPU_BMI2 | CPU_ADX))
+		return mul_mulx;
+#endif
+
+	return NULL;
+}
+
+static f25519_mul_fn mul_fn;
+
+void f25519_mul__distinct(uint8_t *r, const uint8_t *a, const uint8_t *b)
+{
+	/* Resolved on first use. Every thread finds the same backend, so
+	 * a race here is harmless.
+	 */
+#ifdef __GNUC__
+	f25519_mul_fn fn = __atomic_load_n(&mul_fn, __ATOMIC_RELAXED);
+#else
+	f25519_mul_fn fn = mul_fn;
+#endif
+
+	if (!fn) {
+		fn = f25519_mul_backend(cpu_dispatch()->f25519);
+		if (!fn)
+			fn = mul_portable;
+
+#ifdef __GNUC__
+		__atomic_store_n(&mul_fn, fn, __ATOMIC_RELAXED);
+#else
+		mul_fn = fn;
+#endif
+	}
+
+#ifdef C25519_OPCOUNT
+	if (a == b)
+		OPCOUNT(f25519_sqr);
+	else
+		OPCOUNT(f25519_mul);
+#endif
+
+	fn(r, a, b);
+}
+
 void f25519_mul(uint8_t *r, const uint8_t *a, const uint8_t *b)
 {
 	uint8_t tmp[F25519_SIZE];
@@ -196,6 +705,8 @@ void f25519_mul_c(uint8_t *r, const uint8_t *a, uint32_t b)
 	uint32_t c = 0;
 	int i;
 
+	OPCOUNT(f25519_mul_c);
+
 	for (i = 0; i < F25519_SIZE; i++) {
 		c >>= 8;
 		c += b * ((uint32_t)a[i]);
@@ -213,54 +724,26 @@ void f25519_mul_c(uint8_t *r, const uint8_t *a, uint32_t b)
 	}
 }
 
+/* p = 2^255-19 in signed radix 2^30, and p^-1 mod 2^30 */
+static const struct modinv_ctx modinv_p = {
+	.m = {
+		0x3fffffed, 0x3fffffff, 0x3fffffff, 0x3fffffff,
+		0x3fffffff, 0x3fffffff, 0x3fffffff, 0x3fffffff,
+		0x7fff
+	},
+	.minv = 0x179435e5
+};
+
 void f25519_inv__distinct(uint8_t *r, const uint8_t *x)
 {
-	uint8_t s[F25519_SIZE];
-	int i;
+	OPCOUNT(f25519_inv);
 
-	/* This is a prime field, so by Fermat's little theorem:
-	 *
-	 *     x^(p-1) = 1 mod p
-	 *
-	 * Therefore, raise to (p-2) = 2^255-21 to get a multiplicative
-	 * inverse.
-	 *
-	 * This is a 255-bit binary number with the digits:
-	 *
-	 *     11111111... 01011
-	 *
-	 * We compute the result by the usual binary chain, but
-	 * alternate between keeping the accumulator in r and s, so as
-	 * to avoid copying temporaries.
+	/* Elements may be anywhere in [0, 2^256). Reduce first, so that
+	 * p and 2p (which are zero) invert to zero.
 	 */
-
-	/* 1 1 */
-	f25519_mul__distinct(s, x, x);
-	f25519_mul__distinct(r, s, x);
-
-	/* 1 x 248 */
-	for (i = 0; i < 248; i++) {
-		f25519_mul__distinct(s, r, r);
-		f25519_mul__distinct(r, s, x);
-	}
-
-	/* 0 */
-	f25519_mul__distinct(s, r, r);
-
-	/* 1 */
-	f25519_mul__distinct(r, s, s);
-	f25519_mul__distinct(s, r, x);
-
-	/* 0 */
-	f25519_mul__distinct(r, s, s);
-
-	/* 1 */
-	f25519_mul__distinct(s, r, r);
-	f25519_mul__distinct(r, s, x);
-
-	/* 1 */
-	f25519_mul__distinct(s, r, r);
-	f25519_mul__distinct(r, s, x);
+	f25519_copy(r, x);
+	f25519_normalize(r);
+	modinv(r, r, &modinv_p);
 }
 
 void f25519_inv(uint8_t *r, const uint8_t *x)
@@ -308,6 +791,8 @@ void f25519_sqrt(uint8_t *r, const uint8_t *a)
 	uint8_t x[F25519_SIZE];
 	uint8_t y[F25519_SIZE];
 
+	OPCOUNT(f25519_sqrt);
+
 	/* v = (2a)^((p-5)/8) [x = 2a] */
 	f25519_mul_c(x, a, 2);
 	exp2523(v, x, y);
@@ -20,15 +20,28 @@
  *
  * Elements received from the outside may greater even than 2p.
  * f25519_normalize() will correctly deal with these numbers too.
+ *
+ * A relaxed element is any byte string, 0 <= x < 2^256. Multiplication
+ * (f25519_mul(), f25519_mul__distinct() and f25519_mul_c()), addition
+ * and the first operand of subtraction accept relaxed inputs. Other
+ * inputs must be un-normalized elements (x < 2p).
  */
 #define F25519_SIZE  32
 
+/* Linkage of the field functions. The amalgamated build defines this as
+ * "static inline", which makes the field layer private to the one
+ * translation unit, so that it can be inlined into the point formulas.
+ */
+#ifndef F25519_API
+#define F25519_API
+#endif
+
 /* Identity constants */
 extern const uint8_t f25519_zero[F25519_SIZE];
 extern const uint8_t f25519_one[F25519_SIZE];
 
 /* Load a small constant */
-void f25519_load(uint8_t *x, uint32_t c);
+F25519_API void f25519_load(uint8_t *x, uint32_t c);
 
 /* Copy two points */
 static inline void f25519_copy(uint8_t *x, const uint8_t *a)
@@ -37,48 +50,100 @@ static inline void f25519_copy(uint8_t *x, const uint8_t *a)
 }
 
 /* Normalize a field point x < 2*p by subtracting p if necessary */
-void f25519_normalize(uint8_t *x);
+F25519_API void f25519_normalize(uint8_t *x);
 
 /* Compare two field points in constant time. Return one if equal, zero
  * otherwise. This should be performed only on normalized values.
  */
-uint8_t f25519_eq(const uint8_t *x, const uint8_t *y);
+F25519_API uint8_t f25519_eq(const uint8_t *x, const uint8_t *y);
 
 /* Conditional copy. If condition == 0, then zero is copied to dst. If
  * condition == 1, then one is copied to dst. Any other value results in
  * undefined behaviour.
  */
-void f25519_select(uint8_t *dst,
-		   const uint8_t *zero, const uint8_t *one,
-		   uint8_t condition);
+F25519_API void f25519_select(uint8_t *dst,
+			      const uint8_t *zero, const uint8_t *one,
+			      uint8_t condition);
+
+/* Conditional swap. If condition == 1, a and b are exchanged; if it is
+ * zero, neither is changed. Both are always read and written.
+ */
+F25519_API void f25519_cswap(uint8_t *a, uint8_t *b, uint8_t condition);
+
+/* The same, for any object made up of field elements (such as a point
+ * structure). The whole object is swapped in a single pass.
+ */
+F25519_API void f25519_cswap_n(void *a, void *b, size_t size,
+			       uint8_t condition);
+
+/* Constant-time table lookup. Copy entry idx of a table of count
+ * entries, each of the given size, to dst. Every entry is read,
+ * regardless of idx. If idx >= count, dst is zeroed.
+ */
+F25519_API void f25519_lookup(void *dst, const void *table, size_t size,
+			      unsigned int count, unsigned int idx);
 
 /* Add/subtract two field points. The three pointers are not required to
  * be distinct.
  */
-void f25519_add(uint8_t *r, const uint8_t *a, const uint8_t *b);
-void f25519_sub(uint8_t *r, const uint8_t *a, const uint8_t *b);
+F25519_API void f25519_add(uint8_t *r, const uint8_t *a, const uint8_t *b);
+F25519_API void f25519_sub(uint8_t *r, const uint8_t *a, const uint8_t *b);
+
+/* Lazy addition, in a single carry pass. At least one of a and b must
+ * be an un-normalized element (x < 2p); the other may be relaxed. If
+ * both are relaxed, the sum can overflow. Outputs of multiplication
+ * and of the other arithmetic functions are below 2p, but values from
+ * outside (including the coordinates of caller-built points) are not.
+ *
+ * The result is relaxed, and should be used only where relaxed inputs
+ * are accepted (typically as an operand of a multiplication). The
+ * three pointers are not required to be distinct.
+ *
+ * There are no lazy variants of subtraction or negation. These compute
+ * a + kp - b to avoid underflow, and no multiple of p lies in
+ * [2^255 - 1, 2^255], so a single pass can't keep the result below
+ * 2^256 for every b < 2p.
+ */
+F25519_API void f25519_add__lazy(uint8_t *r, const uint8_t *a,
+				 const uint8_t *b);
 
 /* Unary negation */
-void f25519_neg(uint8_t *r, const uint8_t *a);
+F25519_API void f25519_neg(uint8_t *r, const uint8_t *a);
 
 /* Multiply two field points. The __distinct variant is used when r is
  * known to be in a different location to a and b.
  */
-void f25519_mul(uint8_t *r, const uint8_t *a, const uint8_t *b);
-void f25519_mul__distinct(uint8_t *r, const uint8_t *a, const uint8_t *b);
+F25519_API void f25519_mul(uint8_t *r, const uint8_t *a, const uint8_t *b);
+F25519_API void f25519_mul__distinct(uint8_t *r, const uint8_t *a,
+				     const uint8_t *b);
+
+/* Multiplication backends. f25519_mul() and f25519_mul__distinct() use
+ * the one named by cpu_dispatch():
+ *
+ *   "mulx"     four 64-bit limbs, using the BMI2/ADX carry chains
+ *   "radix51"  five 51-bit limbs, on hosts with a 64x64->128 multiply
+ *   "portable" the byte-oriented code
+ *
+ * All produce identical results. Returns NULL if the named backend is
+ * unavailable on this compiler or CPU.
+ */
+typedef void (*f25519_mul_fn)(uint8_t *r, const uint8_t *a,
+			      const uint8_t *b);
+
+F25519_API f25519_mul_fn f25519_mul_backend(const char *name);
 
 /* Multiply a point by a small constant. The two pointers are not
  * required to be distinct.
  *
  * The constant must be less than 2^24.
  */
-void f25519_mul_c(uint8_t *r, const uint8_t *a, uint32_t b);
+F25519_API void f25519_mul_c(uint8_t *r, const uint8_t *a, uint32_t b);
 
 /* Take the reciprocal of a field point. The __distinct variant is used
  * when r is known to be in a different location to x.
  */
-void f25519_inv(uint8_t *r, const uint8_t *x);
-void f25519_inv__distinct(uint8_t *r, const uint8_t *x);
+F25519_API void f25519_inv(uint8_t *r, const uint8_t *x);
+F25519_API void f25519_inv__distinct(uint8_t *r, const uint8_t *x);
 
 /* Compute one of the square roots of the field element, if the element
  * is square. The other square is -r.
@@ -87,6 +152,6 @@ void f25519_inv__distinct(uint8_t *r, const uint8_t *x);
  * element, but not the correct answer. If you don't already know that
  * your element is square, you should square the return value and test.
  */
-void f25519_sqrt(uint8_t *r, const uint8_t *x);
+F25519_API void f25519_sqrt(uint8_t *r, const uint8_t *x);
 
 #endif
@@ -0,0 +1,298 @@
+/* Arithmetic mod 2^255-19, four elements at a time
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef FE4_H_
+#define FE4_H_
+
+#include "f25519.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FE4_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef FE4_AVX2
+
+/* Field elements are held in radix 2^25.5: ten limbs, alternately 26
+ * and 25 bits wide, so that limb i has weight 2^ceil(25.5i). Each limb
+ * is a 256-bit vector holding four unsigned 64-bit lanes, one for each
+ * of four independent elements. The 32x32->64 vector multiply gives us
+ * four limb products per instruction.
+ *
+ * After fe4_carry(), limbs fit in 26 or 25 bits (limbs 1 and 5 may
+ * exceed this by a few bits). Sums and differences of two carried
+ * values may be passed directly to fe4_mul() without overflowing the
+ * 64-bit accumulators.
+ */
+#define FE4_LIMBS  10
+
+struct fe4 {
+	__m256i  l[FE4_LIMBS];
+};
+
+#define AVX2  __attribute__((target("avx2")))
+
+static inline int limb_bits(int i)
+{
+	return (i & 1) ? 25 : 26;
+}
+
+static inline int limb_offset(int i)
+{
+	return (51 * i + 1) >> 1;
+}
+
+/* 2p, for computing differences without underflow */
+static const uint64_t two_p[FE4_LIMBS] = {
+	0x7ffffda, 0x3fffffe, 0x7fffffe, 0x3fffffe, 0x7fffffe,
+	0x3fffffe, 0x7fffffe, 0x3fffffe, 0x7fffffe, 0x3fffffe
+};
+
+static inline AVX2 void fe4_load(struct fe4 *r, const uint8_t *x)
+{
+	int i;
+
+	for (i = 0; i < FE4_LIMBS; i++) {
+		const int off = limb_offset(i);
+		const uint32_t mask = (1 << (i == 9 ? 26 : limb_bits(i))) - 1;
+		uint64_t lane[4];
+		int j;
+
+		/* Bit 255 is kept in limb 9 and reduced by the first carry */
+		for (j = 0; j < 4; j++) {
+			const uint8_t *b = x + j * F25519_SIZE + (off >> 3);
+			const uint32_t w = ((uint32_t)b[0]) |
+				(((uint32_t)b[1]) << 8) |
+				(((uint32_t)b[2]) << 16) |
+				(((uint32_t)b[3]) << 24);
+
+			lane[j] = (w >> (off & 7)) & mask;
+		}
+
+		r->l[i] = _mm256_set_epi64x(lane[3], lane[2],
+					    lane[1], lane[0]);
+	}
+}
+
+static inline AVX2 void fe4_store(uint8_t *x, const struct fe4 *a)
+{
+	uint64_t lanes[FE4_LIMBS][4];
+	int i, j;
+
+	for (i = 0; i < FE4_LIMBS; i++)
+		_mm256_storeu_si256((__m256i *)lanes[i], a->l[i]);
+
+	for (j = 0; j < 4; j++) {
+		uint8_t *out = x + j * F25519_SIZE;
+		uint64_t l[FE4_LIMBS];
+		uint64_t acc = 0;
+		int bits = 0;
+		int k = 0;
+
+		for (i = 0; i < FE4_LIMBS; i++)
+			l[i] = lanes[i][j];
+
+		/* Two carry passes bring the value below 2^256 */
+		for (i = 0; i + 1 < FE4_LIMBS; i++) {
+			l[i + 1] += l[i] >> limb_bits(i);
+			l[i] &= (1 << limb_bits(i)) - 1;
+		}
+
+		l[0] += (l[9] >> 25) * 19;
+		l[9] &= (1 << 25) - 1;
+
+		for (i = 0; i + 1 < FE4_LIMBS; i++) {
+			l[i + 1] += l[i] >> limb_bits(i);
+			l[i] &= (1 << limb_bits(i)) - 1;
+		}
+
+		for (i = 0; i < FE4_LIMBS; i++) {
+			acc |= l[i] << bits;
+			bits += limb_bits(i);
+
+			while (bits >= 8 && k < F25519_SIZE) {
+				out[k++] = acc;
+				acc >>= 8;
+				bits -= 8;
+			}
+		}
+
+		while (k < F25519_SIZE) {
+			out[k++] = acc;
+			acc >>= 8;
+		}
+
+		f25519_normalize(out);
+	}
+}
+
+static inline AVX2 void fe4_add(struct fe4 *r, const struct fe4 *a,
+			 const struct fe4 *b)
+{
+	int i;
+
+	for (i = 0; i < FE4_LIMBS; i++)
+		r->l[i] = _mm256_add_epi64(a->l[i], b->l[i]);
+}
+
+static inline AVX2 void fe4_sub(struct fe4 *r, const struct fe4 *a,
+			 const struct fe4 *b)
+{
+	int i;
+
+	for (i = 0; i < FE4_LIMBS; i++)
+		r->l[i] = _mm256_sub_epi64(
+			_mm256_add_epi64(a->l[i],
+					 _mm256_set1_epi64x(two_p[i])),
+			b->l[i]);
+}
+
+static inline AVX2 void carry_limb(struct fe4 *h, int i)
+{
+	const __m256i mask = _mm256_set1_epi64x((1 << limb_bits(i)) - 1);
+	const __m256i c = _mm256_srli_epi64(h->l[i], limb_bits(i));
+
+	h->l[i] = _mm256_and_si256(h->l[i], mask);
+
+	if (i + 1 < FE4_LIMBS) {
+		h->l[i + 1] = _mm256_add_epi64(h->l[i + 1], c);
+	} else {
+		/* Reduce with 2^255 = 19 mod p: 19c = 16c + 2c + c */
+		const __m256i c19 = _mm256_add_epi64(
+			_mm256_add_epi64(_mm256_slli_epi64(c, 4),
+					 _mm256_slli_epi64(c, 1)), c);
+
+		h->l[0] = _mm256_add_epi64(h->l[0], c19);
+	}
+}
+
+static inline AVX2 void fe4_carry(struct fe4 *h)
+{
+	/* Two interleaved chains, as in the ref10 implementation */
+	carry_limb(h, 0);
+	carry_limb(h, 4);
+	carry_limb(h, 1);
+	carry_limb(h, 5);
+	carry_limb(h, 2);
+	carry_limb(h, 6);
+	carry_limb(h, 3);
+	carry_limb(h, 7);
+	carry_limb(h, 4);
+	carry_limb(h, 8);
+	carry_limb(h, 9);
+	carry_limb(h, 0);
+}
+
+static inline AVX2 void fe4_mul(struct fe4 *r, const struct fe4 *f,
+			 const struct fe4 *g)
+{
+	const __m256i nineteen = _mm256_set1_epi64x(19);
+	__m256i f2[FE4_LIMBS];
+	__m256i g19[FE4_LIMBS];
+	struct fe4 h;
+	int i, j;
+
+	for (i = 0; i < FE4_LIMBS; i++) {
+		f2[i] = _mm256_add_epi64(f->l[i], f->l[i]);
+		g19[i] = _mm256_mul_epu32(g->l[i], nineteen);
+		h.l[i] = _mm256_setzero_si256();
+	}
+
+	/* Products of two odd limbs are doubled, because the weights
+	 * are rounded up. Products which wrap past 2^255 are multiplied
+	 * by 19.
+	 */
+	for (i = 0; i < FE4_LIMBS; i++)
+		for (j = 0; j < FE4_LIMBS; j++) {
+			const __m256i a = (i & j & 1) ? f2[i] : f->l[i];
+			const __m256i b = (i + j >= FE4_LIMBS) ?
+				g19[j] : g->l[j];
+			const int k = (i + j) % FE4_LIMBS;
+
+			h.l[k] = _mm256_add_epi64(h.l[k],
+						  _mm256_mul_epu32(a, b));
+		}
+
+	fe4_carry(&h);
+	*r = h;
+}
+
+static inline AVX2 void fe4_sqn(struct fe4 *r, const struct fe4 *a, int n)
+{
+	fe4_mul(r, a, a);
+
+	while (--n > 0)
+		fe4_mul(r, r, r);
+}
+
+/* Multiply by a constant less than 2^17 */
+static inline AVX2 void fe4_mul_c(struct fe4 *r, const struct fe4 *a, uint32_t c)
+{
+	const __m256i cv = _mm256_set1_epi64x(c);
+	int i;
+
+	for (i = 0; i < FE4_LIMBS; i++)
+		r->l[i] = _mm256_mul_epu32(a->l[i], cv);
+
+	fe4_carry(r);
+}
+
+/* Raise to the power p-2 = 2^255-21, using the addition chain from the
+ * ref10 implementation (254 squarings, 11 multiplications).
+ */
+static inline AVX2 void fe4_inv(struct fe4 *r, const struct fe4 *z)
+{
+	struct fe4 t0, t1, t2, t3;
+
+	fe4_sqn(&t0, z, 1);
+	fe4_sqn(&t1, &t0, 2);
+	fe4_mul(&t1, z, &t1);
+	fe4_mul(&t0, &t0, &t1);
+	fe4_sqn(&t2, &t0, 1);
+	fe4_mul(&t1, &t1, &t2);
+	fe4_sqn(&t2, &t1, 5);
+	fe4_mul(&t1, &t2, &t1);
+	fe4_sqn(&t2, &t1, 10);
+	fe4_mul(&t2, &t2, &t1);
+	fe4_sqn(&t3, &t2, 20);
+	fe4_mul(&t2, &t3, &t2);
+	fe4_sqn(&t2, &t2, 10);
+	fe4_mul(&t1, &t2, &t1);
+	fe4_sqn(&t2, &t1, 50);
+	fe4_mul(&t2, &t2, &t1);
+	fe4_sqn(&t3, &t2, 100);
+	fe4_mul(&t2, &t3, &t2);
+	fe4_sqn(&t2, &t2, 50);
+	fe4_mul(&t1, &t2, &t1);
+	fe4_sqn(&t1, &t1, 5);
+	fe4_mul(r, &t1, &t0);
+}
+
+static inline AVX2 void fe4_cswap(struct fe4 *a, struct fe4 *b, __m256i mask)
+{
+	int i;
+
+	for (i = 0; i < FE4_LIMBS; i++) {
+		const __m256i t = _mm256_and_si256(
+			_mm256_xor_si256(a->l[i], b->l[i]), mask);
+
+		a->l[i] = _mm256_xor_si256(a->l[i], t);
+		b->l[i] = _mm256_xor_si256(b->l[i], t);
+	}
+}
+
+/* Set r = a in those lanes where mask is all ones */
+static inline AVX2 void fe4_cmov(struct fe4 *r, const struct fe4 *a,
+				 __m256i mask)
+{
+	int i;
+
+	for (i = 0; i < FE4_LIMBS; i++)
+		r->l[i] = _mm256_xor_si256(r->l[i], _mm256_and_si256(
+			_mm256_xor_si256(r->l[i], a->l[i]), mask));
+}
+
+#endif /* FE4_AVX2 */
+#endif
@@ -5,6 +5,11 @@
  */
 
 #include "fprime.h"
+#include "opcount.h"
+
+#if FPRIME_SIZE != MODINV_SIZE
+#error "fprime_inv() requires FPRIME_SIZE == MODINV_SIZE"
+#endif
 
 const uint8_t fprime_zero[FPRIME_SIZE] = {0};
 const uint8_t fprime_one[FPRIME_SIZE] = {1};
@@ -153,63 +158,315 @@ void fprime_select(uint8_t *dst,
 
 void fprime_add(uint8_t *r, const uint8_t *a, const uint8_t *modulus)
 {
+	OPCOUNT(fprime_add);
+
 	raw_add(r, a);
 	raw_try_sub(r, modulus);
 }
 
 void fprime_sub(uint8_t *r, const uint8_t *a, const uint8_t *modulus)
 {
+	OPCOUNT(fprime_sub);
+
 	raw_add(r, modulus);
 	raw_try_sub(r, a);
 	raw_try_sub(r, modulus);
 }
 
-void fprime_mul(uint8_t *r, const uint8_t *a, const uint8_t *b,
-		const uint8_t *modulus)
+/* Word-level arithmetic for Montgomery multiplication */
+static void load_words(uint32_t *w, const uint8_t *x)
 {
 	int i;
 
-	memset(r, 0, FPRIME_SIZE);
+	for (i = 0; i < FPRIME_WORDS; i++)
+		w[i] = ((uint32_t)x[i * 4]) |
+		       (((uint32_t)x[i * 4 + 1]) << 8) |
+		       (((uint32_t)x[i * 4 + 2]) << 16) |
+		       (((uint32_t)x[i * 4 + 3]) << 24);
+}
 
-	for (i = prime_msb(modulus); i >= 0; i--) {
-		const uint8_t bit = (b[i >> 3] >> (i & 7)) & 1;
-		uint8_t plusa[FPRIME_SIZE];
+static void store_words(uint8_t *x, const uint32_t *w)
+{
+	int i;
 
-		shift_n_bits(r, 1);
-		raw_try_sub(r, modulus);
+	for (i = 0; i < FPRIME_WORDS; i++) {
+		x[i * 4] = w[i];
+		x[i * 4 + 1] = w[i] >> 8;
+		x[i * 4 + 2] = w[i] >> 16;
+		x[i * 4 + 3] = w[i] >> 24;
+	}
+}
 
-		fprime_copy(plusa, r);
-		fprime_add(plusa, a, modulus);
+/* Given x < 2m, where the top word may be given separately, subtract m
+ * if the result doesn't underflow.
+ */
+static void words_try_sub(uint32_t *r, const uint32_t *x, uint32_t top,
+			  const uint32_t *m)
+{
+	uint32_t minusm[FPRIME_WORDS];
+	uint64_t c = 0;
+	uint32_t mask;
+	int i;
 
-		fprime_select(r, r, plusa, bit);
+	for (i = 0; i < FPRIME_WORDS; i++) {
+		c = ((uint64_t)x[i]) - ((uint64_t)m[i]) - c;
+		minusm[i] = c;
+		c = (c >> 32) & 1;
 	}
+
+	/* Keep x only if the subtraction borrowed from the top word */
+	mask = -(uint32_t)(c & (top ^ 1));
+
+	for (i = 0; i < FPRIME_WORDS; i++)
+		r[i] = minusm[i] ^ (mask & (x[i] ^ minusm[i]));
 }
 
-void fprime_inv(uint8_t *r, const uint8_t *a, const uint8_t *modulus)
+/* Montgomery product: r = ab/R mod m, with r < m. The product ab must
+ * be less than mR (it suffices that either a or b is less than m). The
+ * pointers are not required to be distinct.
+ */
+static void mont_mul(uint32_t *r, const uint32_t *a, const uint32_t *b,
+		     const struct fprime_ctx *ctx)
 {
-	uint8_t pm2[FPRIME_SIZE];
-	uint16_t c = 2;
+	uint32_t t[FPRIME_WORDS + 2] = {0};
+	int i, j;
+
+	for (i = 0; i < FPRIME_WORDS; i++) {
+		uint64_t c = 0;
+		uint32_t q;
+
+		/* t += a * b[i] */
+		for (j = 0; j < FPRIME_WORDS; j++) {
+			c += ((uint64_t)t[j]) + ((uint64_t)a[j]) * b[i];
+			t[j] = c;
+			c >>= 32;
+		}
+
+		c += t[FPRIME_WORDS];
+		t[FPRIME_WORDS] = c;
+		t[FPRIME_WORDS + 1] = c >> 32;
+
+		/* t = (t + q * m) / 2^32, choosing q to make this exact */
+		q = t[0] * ctx->minv;
+		c = ((uint64_t)t[0]) + ((uint64_t)q) * ctx->m[0];
+		c >>= 32;
+
+		for (j = 1; j < FPRIME_WORDS; j++) {
+			c += ((uint64_t)t[j]) + ((uint64_t)q) * ctx->m[j];
+			t[j - 1] = c;
+			c >>= 32;
+		}
+
+		c += t[FPRIME_WORDS];
+		t[FPRIME_WORDS - 1] = c;
+		t[FPRIME_WORDS] = t[FPRIME_WORDS + 1] + (c >> 32);
+	}
+
+	/* t < 2m */
+	words_try_sub(r, t, t[FPRIME_WORDS], ctx->m);
+}
+
+void fprime_ctx_init(struct fprime_ctx *ctx, const uint8_t *modulus)
+{
+	const int msb = prime_msb(modulus);
+	uint32_t x[FPRIME_WORDS] = {0};
+	uint32_t inv;
+	int t = FPRIME_WORDS * 32;
+	int s = 0;
 	int i;
 
-	/* Compute (p-2) */
-	fprime_copy(pm2, modulus);
-	for (i = 0; i < FPRIME_SIZE; i++) {
-		c = modulus[i] - c;
-		pm2[i] = c;
-		c >>= 8;
+	load_words(ctx->m, modulus);
+
+	/* Newton iteration doubles the number of correct low bits. Any
+	 * odd number is its own inverse mod 8.
+	 */
+	inv = ctx->m[0];
+	for (i = 0; i < 4; i++)
+		inv *= 2 - ctx->m[0] * inv;
+	ctx->minv = -inv;
+
+	/* R^2 = (2^t R)^(2^s) / R^(2^s - 1), where t 2^s = log2(R). Start
+	 * from 2^msb < m and double to obtain 2^t R mod m, then use
+	 * Montgomery squarings for the rest.
+	 */
+	while (!(t & 1) && t > 8) {
+		t >>= 1;
+		s++;
+	}
+
+	x[msb >> 5] = ((uint32_t)1) << (msb & 31);
+
+	for (i = msb; i < FPRIME_WORDS * 32 + t; i++) {
+		uint32_t c = 0;
+		int j;
+
+		for (j = 0; j < FPRIME_WORDS; j++) {
+			const uint32_t next = x[j] >> 31;
+
+			x[j] = (x[j] << 1) | c;
+			c = next;
+		}
+
+		words_try_sub(x, x, c, ctx->m);
+	}
+
+	for (i = 0; i < s; i++)
+		mont_mul(x, x, x, ctx);
+
+	memcpy(ctx->r2, x, sizeof(x));
+
+	modinv_init(&ctx->inv, modulus);
+}
+
+/* r = a + b mod m, for a, b < m */
+static void words_add(uint32_t *r, const uint32_t *a, const uint32_t *b,
+		      const uint32_t *m)
+{
+	uint32_t t[FPRIME_WORDS];
+	uint64_t c = 0;
+	int i;
+
+	for (i = 0; i < FPRIME_WORDS; i++) {
+		c += ((uint64_t)a[i]) + ((uint64_t)b[i]);
+		t[i] = c;
+		c >>= 32;
+	}
+
+	words_try_sub(r, t, c, m);
+}
+
+void fprime_ctx_from_bytes(uint8_t *r,
+			   const uint8_t *x, size_t len,
+			   const struct fprime_ctx *ctx)
+{
+	const uint32_t one[FPRIME_WORDS] = {1};
+	size_t top = len % FPRIME_SIZE;
+	uint32_t acc[FPRIME_WORDS] = {0};
+
+	if (!top && len)
+		top = FPRIME_SIZE;
+
+	/* Horner's rule in base R, most significant chunk first:
+	 *
+	 *     acc <- acc R + chunk
+	 *
+	 * where acc R = mont(acc, R^2) and chunk mod m is obtained as
+	 * mont(mont(chunk, R^2), 1).
+	 */
+	while (len) {
+		uint8_t buf[FPRIME_SIZE] = {0};
+		uint32_t w[FPRIME_WORDS];
+
+		len -= top;
+		memcpy(buf, x + len, top);
+		top = FPRIME_SIZE;
+
+		load_words(w, buf);
+		mont_mul(w, w, ctx->r2, ctx);
+		mont_mul(w, w, one, ctx);
+
+		mont_mul(acc, acc, ctx->r2, ctx);
+		words_add(acc, acc, w, ctx->m);
 	}
 
-	/* Binary exponentiation */
-	fprime_load(r, 1);
+	store_words(r, acc);
+}
+
+void fprime_ctx_normalize(uint8_t *x, const struct fprime_ctx *ctx)
+{
+	fprime_ctx_from_bytes(x, x, FPRIME_SIZE, ctx);
+}
+
+void fprime_ctx_add(uint8_t *r, const uint8_t *a,
+		    const struct fprime_ctx *ctx)
+{
+	uint32_t wr[FPRIME_WORDS];
+	uint32_t wa[FPRIME_WORDS];
+
+	OPCOUNT(fprime_add);
 
-	for (i = prime_msb(modulus); i >= 0; i--) {
-		uint8_t r2[FPRIME_SIZE];
+	load_words(wr, r);
+	load_words(wa, a);
+	words_add(wr, wr, wa, ctx->m);
+	store_words(r, wr);
+}
+
+void fprime_ctx_sub(uint8_t *r, const uint8_t *a,
+		    const struct fprime_ctx *ctx)
+{
+	uint32_t wr[FPRIME_WORDS];
+	uint32_t wa[FPRIME_WORDS];
+	uint64_t c = 0;
+	uint32_t mask;
+	int i;
+
+	OPCOUNT(fprime_sub);
 
-		fprime_mul(r2, r, r, modulus);
+	load_words(wr, r);
+	load_words(wa, a);
 
-		if ((pm2[i >> 3] >> (i & 7)) & 1)
-			fprime_mul(r, r2, a, modulus);
-		else
-			fprime_copy(r, r2);
+	for (i = 0; i < FPRIME_WORDS; i++) {
+		c = ((uint64_t)wr[i]) - ((uint64_t)wa[i]) - c;
+		wr[i] = c;
+		c = (c >> 32) & 1;
 	}
+
+	/* Add back m if the subtraction underflowed */
+	mask = -(uint32_t)c;
+	c = 0;
+
+	for (i = 0; i < FPRIME_WORDS; i++) {
+		c += ((uint64_t)wr[i]) + (ctx->m[i] & mask);
+		wr[i] = c;
+		c >>= 32;
+	}
+
+	store_words(r, wr);
+}
+
+void fprime_ctx_inv(uint8_t *r, const uint8_t *a,
+		    const struct fprime_ctx *ctx)
+{
+	OPCOUNT(fprime_inv);
+
+	modinv(r, a, &ctx->inv);
+}
+
+void fprime_ctx_mul(uint8_t *r, const uint8_t *a, const uint8_t *b,
+		    const struct fprime_ctx *ctx)
+{
+	uint32_t wa[FPRIME_WORDS];
+	uint32_t wb[FPRIME_WORDS];
+
+	OPCOUNT(fprime_mul);
+
+	load_words(wa, a);
+	load_words(wb, b);
+
+	/* (aR^2/R) b / R = ab. Converting a first means that neither
+	 * input need be reduced.
+	 */
+	mont_mul(wa, wa, ctx->r2, ctx);
+	mont_mul(wa, wa, wb, ctx);
+
+	store_words(r, wa);
+}
+
+void fprime_mul(uint8_t *r, const uint8_t *a, const uint8_t *b,
+		const uint8_t *modulus)
+{
+	struct fprime_ctx ctx;
+
+	fprime_ctx_init(&ctx, modulus);
+	fprime_ctx_mul(r, a, b, &ctx);
+}
+
+void fprime_inv(uint8_t *r, const uint8_t *a, const uint8_t *modulus)
+{
+	struct modinv_ctx ctx;
+
+	OPCOUNT(fprime_inv);
+
+	modinv_init(&ctx, modulus);
+	modinv(r, a, &ctx);
 }
@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 #include <string.h>
+#include "modinv.h"
 
 /* Maximum size of a field element (or a prime). Field elements are
  * always manipulated and stored in normalized form, with 0 <= x < p.
@@ -64,6 +65,47 @@ void fprime_sub(uint8_t *r, const uint8_t *a, const uint8_t *modulus);
 void fprime_mul(uint8_t *r, const uint8_t *a, const uint8_t *b,
 		const uint8_t *modulus);
 
+/* Multiplication is performed on 32-bit words, using Montgomery's
+ * method with R = 2^(8 * FPRIME_SIZE). FPRIME_SIZE must therefore be a
+ * multiple of four, and the modulus must be odd.
+ *
+ * The constants required depend only on the modulus. They can be
+ * computed once and kept in a context, rather than being recomputed by
+ * each call to fprime_mul().
+ */
+#define FPRIME_WORDS  (FPRIME_SIZE / 4)
+
+struct fprime_ctx {
+	uint32_t		m[FPRIME_WORDS];	/* The modulus */
+	uint32_t		r2[FPRIME_WORDS];	/* R^2 mod m */
+	uint32_t		minv;			/* -m^-1 mod 2^32 */
+	struct modinv_ctx	inv;			/* For fprime_ctx_inv() */
+};
+
+/* Prepare a context for the given modulus */
+void fprime_ctx_init(struct fprime_ctx *ctx, const uint8_t *modulus);
+
+/* Variants of the functions above which take a prepared context in
+ * place of the modulus. Unlike the originals, none of these require
+ * their pointer arguments to be distinct.
+ */
+void fprime_ctx_from_bytes(uint8_t *r,
+			   const uint8_t *x, size_t len,
+			   const struct fprime_ctx *ctx);
+void fprime_ctx_normalize(uint8_t *x, const struct fprime_ctx *ctx);
+void fprime_ctx_add(uint8_t *r, const uint8_t *a,
+		    const struct fprime_ctx *ctx);
+void fprime_ctx_sub(uint8_t *r, const uint8_t *a,
+		    const struct fprime_ctx *ctx);
+void fprime_ctx_inv(uint8_t *r, const uint8_t *a,
+		    const struct fprime_ctx *ctx);
+
+/* Multiply two values, using a prepared context. The inputs need not
+ * be normalized.
+ */
+void fprime_ctx_mul(uint8_t *r, const uint8_t *a, const uint8_t *b,
+		    const struct fprime_ctx *ctx);
+
 /* Compute multiplicative inverse. r must be distinct from a */
 void fprime_inv(uint8_t *r, const uint8_t *a, const uint8_t *modulus);
 
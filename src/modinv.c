@@ -0,0 +1,263 @@
+/* Constant-time modular inversion
+ *
+ * This file is in the public domain.
+ *
+ * The structure of this implementation follows the 32-bit version of
+ * safegcd in libsecp256k1 (src/modinv32_impl.h), which is described in
+ * detail in that project's doc/safegcd_implementation.md.
+ *
+ * Note that right shifts of negative numbers are assumed to be
+ * arithmetic (sign-extending). This is true of all compilers that we
+ * know of.
+ */
+
+#include <string.h>
+#include "modinv.h"
+
+#define M30  ((int32_t)(UINT32_MAX >> 2))
+
+/* Numbers in signed radix 2^30. Limbs may be negative. */
+struct signed30 {
+	int32_t   v[MODINV_LIMBS];
+};
+
+/* Transition matrix for 30 divsteps, scaled by 2^30 */
+struct trans2x2 {
+	int32_t   u, v, q, r;
+};
+
+static void from_bytes(int32_t *v, const uint8_t *x)
+{
+	uint64_t acc = 0;
+	int bits = 0;
+	int i, j = 0;
+
+	for (i = 0; i < MODINV_LIMBS; i++) {
+		while (bits < 30 && j < MODINV_SIZE) {
+			acc |= ((uint64_t)x[j++]) << bits;
+			bits += 8;
+		}
+
+		v[i] = acc & M30;
+		acc >>= 30;
+		bits -= 30;
+	}
+}
+
+/* Limbs must be in [0, 2^30) */
+static void to_bytes(uint8_t *x, const int32_t *v)
+{
+	uint64_t acc = 0;
+	int bits = 0;
+	int i, j = 0;
+
+	for (i = 0; i < MODINV_LIMBS; i++) {
+		acc |= ((uint64_t)v[i]) << bits;
+		bits += 30;
+
+		while (bits >= 8 && j < MODINV_SIZE) {
+			x[j++] = acc;
+			acc >>= 8;
+			bits -= 8;
+		}
+	}
+}
+
+void modinv_init(struct modinv_ctx *ctx, const uint8_t *modulus)
+{
+	uint32_t inv;
+	int i;
+
+	from_bytes(ctx->m, modulus);
+
+	/* Newton iteration: any odd number is its own inverse mod 8 */
+	inv = ctx->m[0];
+	for (i = 0; i < 4; i++)
+		inv *= 2 - ctx->m[0] * inv;
+
+	ctx->minv = inv & M30;
+}
+
+/* Perform 30 divsteps on the low bits of f and g, in constant time,
+ * returning the new value of zeta = -(delta + 1/2). The matrix entries
+ * are kept unsigned, so that left shifts are well-defined.
+ */
+static int32_t divsteps_30(int32_t zeta, uint32_t f0, uint32_t g0,
+			   struct trans2x2 *t)
+{
+	uint32_t u = 1, v = 0, q = 0, r = 1;
+	uint32_t f = f0, g = g0;
+	int i;
+
+	for (i = 0; i < 30; i++) {
+		/* c1 is a mask for zeta < 0, c2 for g odd. As in
+		 * libsecp256k1, they are volatile, so that the compiler
+		 * can't turn the masked updates back into branches on
+		 * secret data.
+		 */
+		volatile uint32_t c1 = zeta >> 31;
+		volatile uint32_t c2 = -(g & 1);
+		const uint32_t x = (f ^ c1) - c1;
+		const uint32_t y = (u ^ c1) - c1;
+		const uint32_t z = (v ^ c1) - c1;
+
+		/* If g is odd, add (possibly negated) f, u, v to g, q, r */
+		g += x & c2;
+		q += y & c2;
+		r += z & c2;
+
+		/* If both, swap: zeta becomes -zeta - 2, else zeta - 1 */
+		c1 &= c2;
+		zeta = (zeta ^ (int32_t)c1) - 1;
+
+		f += g & c1;
+		u += q & c1;
+		v += r & c1;
+
+		g >>= 1;
+		u <<= 1;
+		v <<= 1;
+	}
+
+	t->u = (int32_t)u;
+	t->v = (int32_t)v;
+	t->q = (int32_t)q;
+	t->r = (int32_t)r;
+
+	return zeta;
+}
+
+/* Compute (t [d, e]) / 2^30 mod m, keeping d and e in (-2m, m) */
+static void update_de_30(struct signed30 *d, struct signed30 *e,
+			 const struct trans2x2 *t,
+			 const struct modinv_ctx *ctx)
+{
+	const int32_t u = t->u, v = t->v, q = t->q, r = t->r;
+	const int32_t sd = d->v[MODINV_LIMBS - 1] >> 31;
+	const int32_t se = e->v[MODINV_LIMBS - 1] >> 31;
+	int32_t md = (u & sd) + (v & se);
+	int32_t me = (q & sd) + (r & se);
+	int64_t cd, ce;
+	int i;
+
+	cd = (int64_t)u * d->v[0] + (int64_t)v * e->v[0];
+	ce = (int64_t)q * d->v[0] + (int64_t)r * e->v[0];
+
+	/* Choose multiples of m that make the low 30 bits zero */
+	md -= (ctx->minv * (uint32_t)cd + md) & M30;
+	me -= (ctx->minv * (uint32_t)ce + me) & M30;
+
+	cd += (int64_t)ctx->m[0] * md;
+	ce += (int64_t)ctx->m[0] * me;
+	cd >>= 30;
+	ce >>= 30;
+
+	for (i = 1; i < MODINV_LIMBS; i++) {
+		cd += (int64_t)u * d->v[i] + (int64_t)v * e->v[i];
+		ce += (int64_t)q * d->v[i] + (int64_t)r * e->v[i];
+		cd += (int64_t)ctx->m[i] * md;
+		ce += (int64_t)ctx->m[i] * me;
+
+		d->v[i - 1] = (int32_t)cd & M30;
+		e->v[i - 1] = (int32_t)ce & M30;
+		cd >>= 30;
+		ce >>= 30;
+	}
+
+	d->v[MODINV_LIMBS - 1] = (int32_t)cd;
+	e->v[MODINV_LIMBS - 1] = (int32_t)ce;
+}
+
+/* Compute (t [f, g]) / 2^30, which is exact */
+static void update_fg_30(struct signed30 *f, struct signed30 *g,
+			 const struct trans2x2 *t)
+{
+	const int32_t u = t->u, v = t->v, q = t->q, r = t->r;
+	int64_t cf, cg;
+	int i;
+
+	cf = (int64_t)u * f->v[0] + (int64_t)v * g->v[0];
+	cg = (int64_t)q * f->v[0] + (int64_t)r * g->v[0];
+	cf >>= 30;
+	cg >>= 30;
+
+	for (i = 1; i < MODINV_LIMBS; i++) {
+		cf += (int64_t)u * f->v[i] + (int64_t)v * g->v[i];
+		cg += (int64_t)q * f->v[i] + (int64_t)r * g->v[i];
+
+		f->v[i - 1] = (int32_t)cf & M30;
+		g->v[i - 1] = (int32_t)cg & M30;
+		cf >>= 30;
+		cg >>= 30;
+	}
+
+	f->v[MODINV_LIMBS - 1] = (int32_t)cf;
+	g->v[MODINV_LIMBS - 1] = (int32_t)cg;
+}
+
+/* Add m if x is negative, then propagate carries */
+static void add_m_if_negative(struct signed30 *x,
+			      const struct modinv_ctx *ctx)
+{
+	const int32_t cond = x->v[MODINV_LIMBS - 1] >> 31;
+	int i;
+
+	for (i = 0; i < MODINV_LIMBS; i++)
+		x->v[i] += ctx->m[i] & cond;
+
+	for (i = 0; i + 1 < MODINV_LIMBS; i++) {
+		x->v[i + 1] += x->v[i] >> 30;
+		x->v[i] &= M30;
+	}
+}
+
+/* Bring x from (-2m, m) into [0, m), negating it if sign < 0 */
+static void normalize_30(struct signed30 *x, int32_t sign,
+			 const struct modinv_ctx *ctx)
+{
+	const int32_t neg = sign >> 31;
+	const int32_t cond = x->v[MODINV_LIMBS - 1] >> 31;
+	int i;
+
+	/* (-2m, m) -> (-m, m), negating on the way */
+	for (i = 0; i < MODINV_LIMBS; i++) {
+		x->v[i] += ctx->m[i] & cond;
+		x->v[i] = (x->v[i] ^ neg) - neg;
+	}
+
+	for (i = 0; i + 1 < MODINV_LIMBS; i++) {
+		x->v[i + 1] += x->v[i] >> 30;
+		x->v[i] &= M30;
+	}
+
+	/* (-m, m) -> [0, m) */
+	add_m_if_negative(x, ctx);
+}
+
+void modinv(uint8_t *r, const uint8_t *x, const struct modinv_ctx *ctx)
+{
+	struct signed30 d = {{0}};
+	struct signed30 e = {{1}};
+	struct signed30 f;
+	struct signed30 g;
+	int32_t zeta = -1;
+	int i;
+
+	memcpy(f.v, ctx->m, sizeof(f.v));
+	from_bytes(g.v, x);
+
+	/* 20 batches of 30 divsteps. 590 divsteps suffice for inputs of
+	 * up to 256 bits. Throughout, d x = f and e x = g (mod m).
+	 */
+	for (i = 0; i < 20; i++) {
+		struct trans2x2 t;
+
+		zeta = divsteps_30(zeta, f.v[0], g.v[0], &t);
+		update_de_30(&d, &e, &t, ctx);
+		update_fg_30(&f, &g, &t);
+	}
+
+	/* Now g = 0 and f = +/-gcd(m, x), so d is +/- the inverse */
+	normalize_30(&d, f.v[MODINV_LIMBS - 1], ctx);
+	to_bytes(r, d.v);
+}
@@ -0,0 +1,46 @@
+/* Constant-time modular inversion
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef MODINV_H_
+#define MODINV_H_
+
+#include <stdint.h>
+
+/* Inversion modulo an odd number m < 2^256, using the "safegcd"
+ * algorithm:
+ *
+ *     Bernstein, D.J. & Yang, B-Y. (2019) "Fast constant-time gcd
+ *     computation and modular inversion". IACR Transactions on
+ *     Cryptographic Hardware and Embedded Systems, 2019(3), 340-398.
+ *
+ * The algorithm performs a fixed number of division steps, batched 30
+ * at a time into matrix updates on signed 30-bit limbs. This is many
+ * times faster than inversion by exponentiation (Fermat's little
+ * theorem), and its timing is independent of the value being inverted.
+ * It is not independent of the modulus.
+ *
+ * Numbers are passed as 32-byte little-endian strings.
+ */
+#define MODINV_SIZE   32
+#define MODINV_LIMBS  9
+
+/* Precomputed information about a modulus */
+struct modinv_ctx {
+	int32_t   m[MODINV_LIMBS];	/* Modulus, in signed radix 2^30 */
+	uint32_t  minv;			/* m^-1 mod 2^30 */
+};
+
+/* Prepare a context for an odd modulus */
+void modinv_init(struct modinv_ctx *ctx, const uint8_t *modulus);
+
+/* Compute r = x^-1 mod m, with 0 <= r < m. x may be any 32-byte
+ * string, and need not be reduced. If x = 0, the result is zero. For
+ * any other x which is not invertible (including non-zero multiples of
+ * m), the result is meaningless. The two pointers are not required to
+ * be distinct.
+ */
+void modinv(uint8_t *r, const uint8_t *x, const struct modinv_ctx *ctx);
+
+#endif
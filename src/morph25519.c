@@ -255,6 +255,28 @@ void morph25519_e2w(uint8_t* wx, uint8_t* wy, const uint8_t* ex, const uint8_t*
 	f25519_normalize(wy);        				//  wy = (c * (1 + ey)) * ((1 - ey) * ex)^-1  (mod p)
 }
 
+uint8_t morph25519_wx_eq_ey(const uint8_t *wx,
+			    const uint8_t *ey, const uint8_t *ez)
+{
+	/*
+		The following code checks:
+		(wx - delta) * (ez - ey) == ez + ey   (mod p)
+	*/
+	uint8_t lhs[F25519_SIZE];
+	uint8_t rhs[F25519_SIZE];
+	uint8_t den[F25519_SIZE];
+
+	f25519_sub(rhs, wx, f25519_delta);      // rhs = wx - delta
+	f25519_sub(den, ez, ey);                // den =              ez - ey
+	f25519_mul__distinct(lhs, rhs, den);    // lhs = (wx - delta) * (ez - ey)
+	f25519_add(rhs, ez, ey);                // rhs = ez + ey
+	f25519_normalize(lhs);
+	f25519_normalize(rhs);
+
+	/* If ez = ey, then lhs = 0 but rhs = 2ez, which is non-zero */
+	return f25519_eq(lhs, rhs);
+}
+
 void morph25519_w2e(uint8_t* ex, uint8_t* ey, const uint8_t* wx, const uint8_t* wy)
 {
 	/*
@@ -121,6 +121,21 @@ void morph25519_w2m(uint8_t* mx, uint8_t* my, const uint8_t* wx, const uint8_t*
  */
 void morph25519_e2w(uint8_t* wx, uint8_t* wy, const uint8_t* ex, const uint8_t* ey);
 
+/*
+ * Compares the x-coordinate of a point on the short Weierstrass curve
+ * Wei25519 with that of a projective point on the Edwards curve Ed25519,
+ * without an inversion. Only the Edwards Y and Z coordinates are needed.
+ *
+ * Input:
+ * 	WX, any value
+ * 	(EY : EZ), the y-coordinate of a point on Ed25519
+ * Return:
+ * 	1 if WX = (EZ + EY) / (EZ - EY) + delta, zero otherwise. The
+ * 	neutral point (EY = EZ) never matches.
+ */
+uint8_t morph25519_wx_eq_ey(const uint8_t *wx,
+			    const uint8_t *ey, const uint8_t *ez);
+
 /*
  * Transforms an affine point on the short Weierstrass curve Wei25519
  * to an affine point on the Edwards curve Ed25519.
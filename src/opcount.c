@@ -0,0 +1,36 @@
+/* Counting of field operations, for tuning point formulas
+ *
+ * This file is in the public domain.
+ */
+
+#include <string.h>
+#include "opcount.h"
+
+#ifdef C25519_OPCOUNT
+OPCOUNT_TLS struct opcount opcount_thread;
+#endif
+
+int opcount_enabled(void)
+{
+#ifdef C25519_OPCOUNT
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+void opcount_reset(void)
+{
+#ifdef C25519_OPCOUNT
+	memset(&opcount_thread, 0, sizeof(opcount_thread));
+#endif
+}
+
+void opcount_snapshot(struct opcount *c)
+{
+#ifdef C25519_OPCOUNT
+	memcpy(c, &opcount_thread, sizeof(*c));
+#else
+	memset(c, 0, sizeof(*c));
+#endif
+}
@@ -0,0 +1,73 @@
+/* Counting of field operations, for tuning point formulas
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef OPCOUNT_H_
+#define OPCOUNT_H_
+
+/* When the package is built with C25519_OPCOUNT defined, the field
+ * layers (f25519, fprime and sc25519) count each operation they
+ * perform. Counts are kept per thread. In a normal build, the counters
+ * are never touched and remain zero.
+ *
+ * Each operation is counted once, where it is implemented: f25519_mul()
+ * counts as one multiplication, not as a multiplication plus a copy.
+ * Operations used internally by another are counted too, so that the
+ * counts for f25519_sqrt() include the multiplications of its
+ * exponentiation.
+ *
+ * The AVX2 point code (ed25519_x4, c25519_x4) doesn't go through
+ * f25519, and isn't counted. Set C25519_PORTABLE to profile the
+ * byte-oriented formulas.
+ */
+struct opcount {
+	unsigned long	f25519_mul;	/* f25519_mul__distinct(), a != b */
+	unsigned long	f25519_sqr;	/* the same, with a == b */
+	unsigned long	f25519_mul_c;
+	unsigned long	f25519_add;
+	unsigned long	f25519_add_lazy;
+	unsigned long	f25519_sub;
+	unsigned long	f25519_neg;
+	unsigned long	f25519_inv;
+	unsigned long	f25519_sqrt;
+
+	unsigned long	fprime_mul;
+	unsigned long	fprime_add;
+	unsigned long	fprime_sub;
+	unsigned long	fprime_inv;
+
+	unsigned long	sc25519_mul;	/* sc25519_mul(), sc25519_muladd() */
+	unsigned long	sc25519_add;
+	unsigned long	sc25519_inv;
+	unsigned long	sc25519_reduce;	/* sc25519_from_bytes() */
+};
+
+/* Return non-zero if the package was built with C25519_OPCOUNT */
+int opcount_enabled(void);
+
+/* Zero this thread's counters */
+void opcount_reset(void);
+
+/* Copy this thread's counters */
+void opcount_snapshot(struct opcount *c);
+
+/* Incrementing the counters, for the field layers */
+#ifdef C25519_OPCOUNT
+
+#if defined(__GNUC__)
+#define OPCOUNT_TLS  __thread
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define OPCOUNT_TLS  _Thread_local
+#else
+#define OPCOUNT_TLS
+#endif
+
+extern OPCOUNT_TLS struct opcount opcount_thread;
+
+#define OPCOUNT(op)  (opcount_thread.op++)
+#else
+#define OPCOUNT(op)  ((void)0)
+#endif
+
+#endif
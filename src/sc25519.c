@@ -0,0 +1,217 @@
+/* Arithmetic mod the order of the Ed25519 base point
+ *
+ * This file is in the public domain.
+ */
+
+#include <string.h>
+#include "sc25519.h"
+#include "modinv.h"
+#include "opcount.h"
+
+/* Numbers are handled internally as little-endian arrays of 32-bit
+ * words. Barrett reduction works with k = 8 words.
+ */
+#define K  8
+
+const uint8_t sc25519_order[SC25519_SIZE] = {
+	0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+	0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+};
+
+static const uint32_t order_words[K] = {
+	0x5cf5d3ed, 0x5812631a, 0xa2f79cd6, 0x14def9de,
+	0x00000000, 0x00000000, 0x00000000, 0x10000000
+};
+
+/* mu = floor(2^512 / L) */
+static const uint32_t mu[K + 1] = {
+	0x0a2c131b, 0xed9ce5a3, 0x086329a7, 0x2106215d,
+	0xffffffeb, 0xffffffff, 0xffffffff, 0xffffffff,
+	0x0000000f
+};
+
+static void sc_load_words(uint32_t *w, const uint8_t *x, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (!(i & 3))
+			w[i >> 2] = 0;
+
+		w[i >> 2] |= ((uint32_t)x[i]) << ((i & 3) << 3);
+	}
+}
+
+static void sc_store_words(uint8_t *x, const uint32_t *w)
+{
+	int i;
+
+	for (i = 0; i < SC25519_SIZE; i++)
+		x[i] = w[i >> 2] >> ((i & 3) << 3);
+}
+
+/* r = x - L, if that doesn't underflow. Both arrays have K + 1 words. */
+static void try_sub(uint32_t *x)
+{
+	uint32_t minusl[K + 1];
+	uint64_t c = 0;
+	uint32_t mask;
+	int i;
+
+	for (i = 0; i < K + 1; i++) {
+		const uint32_t l = (i < K) ? order_words[i] : 0;
+
+		c = ((uint64_t)x[i]) - ((uint64_t)l) - c;
+		minusl[i] = c;
+		c = (c >> 32) & 1;
+	}
+
+	mask = -(uint32_t)c;
+
+	for (i = 0; i < K + 1; i++)
+		x[i] = minusl[i] ^ (mask & (x[i] ^ minusl[i]));
+}
+
+/* Barrett reduction (Menezes, van Oorschot & Vanstone, Handbook of
+ * Applied Cryptography, algorithm 14.42). Given x < 2^512 in 2K words,
+ * compute x mod L.
+ */
+static void barrett_reduce(uint8_t *r, const uint32_t *x)
+{
+	uint32_t q[2 * K + 2] = {0};
+	uint32_t t[K + 1];
+	uint64_t c;
+	int i, j;
+
+	/* q = floor(floor(x / b^(k-1)) mu / b^(k+1)) */
+	for (i = 0; i < K + 1; i++) {
+		c = 0;
+
+		for (j = 0; j < K + 1; j++) {
+			c += ((uint64_t)q[i + j]) +
+				((uint64_t)x[K - 1 + i]) * mu[j];
+			q[i + j] = c;
+			c >>= 32;
+		}
+
+		q[i + K + 1] = c;
+	}
+
+	/* t = qL mod b^(k+1). Only the low words of the product are
+	 * needed, and q is at most k + 1 words long.
+	 */
+	memset(t, 0, sizeof(t));
+
+	for (i = 0; i < K + 1; i++) {
+		c = 0;
+
+		for (j = 0; i + j < K + 1; j++) {
+			const uint32_t l = (j < K) ? order_words[j] : 0;
+
+			c += ((uint64_t)t[i + j]) +
+				((uint64_t)q[K + 1 + i]) * l;
+			t[i + j] = c;
+			c >>= 32;
+		}
+	}
+
+	/* t = x - qL mod b^(k+1). The true difference is less than 3L. */
+	c = 0;
+	for (i = 0; i < K + 1; i++) {
+		c = ((uint64_t)x[i]) - ((uint64_t)t[i]) - c;
+		t[i] = c;
+		c = (c >> 32) & 1;
+	}
+
+	try_sub(t);
+	try_sub(t);
+	sc_store_words(r, t);
+}
+
+void sc25519_from_bytes(uint8_t *r, const uint8_t *x, size_t len)
+{
+	uint32_t w[2 * K] = {0};
+
+	OPCOUNT(sc25519_reduce);
+
+	sc_load_words(w, x, len);
+	barrett_reduce(r, w);
+}
+
+void sc25519_add(uint8_t *r, const uint8_t *a, const uint8_t *b)
+{
+	uint32_t w[2 * K] = {0};
+	uint16_t c = 0;
+	uint8_t sum[SC25519_SIZE + 1];
+	int i;
+
+	OPCOUNT(sc25519_add);
+
+	for (i = 0; i < SC25519_SIZE; i++) {
+		c += ((uint16_t)a[i]) + ((uint16_t)b[i]);
+		sum[i] = c;
+		c >>= 8;
+	}
+
+	sum[SC25519_SIZE] = c;
+	sc_load_words(w, sum, sizeof(sum));
+	barrett_reduce(r, w);
+}
+
+void sc25519_muladd(uint8_t *s, const uint8_t *a, const uint8_t *b,
+		    const uint8_t *c)
+{
+	uint32_t wa[K];
+	uint32_t wb[K];
+	uint32_t w[2 * K] = {0};
+	uint64_t carry;
+	int i, j;
+
+	OPCOUNT(sc25519_mul);
+
+	sc_load_words(wa, a, SC25519_SIZE);
+	sc_load_words(wb, b, SC25519_SIZE);
+	sc_load_words(w, c, SC25519_SIZE);
+
+	/* ab + c < 2^512. Word i + K is untouched until row i. */
+	for (i = 0; i < K; i++) {
+		carry = 0;
+
+		for (j = 0; j < K; j++) {
+			carry += ((uint64_t)w[i + j]) +
+				((uint64_t)wa[i]) * wb[j];
+			w[i + j] = carry;
+			carry >>= 32;
+		}
+
+		w[i + K] = carry;
+	}
+
+	barrett_reduce(s, w);
+}
+
+void sc25519_mul(uint8_t *r, const uint8_t *a, const uint8_t *b)
+{
+	static const uint8_t zero[SC25519_SIZE] = {0};
+
+	sc25519_muladd(r, a, b, zero);
+}
+
+/* L in signed radix 2^30, and L^-1 mod 2^30 */
+static const struct modinv_ctx modinv_order = {
+	.m = {
+		0x1cf5d3ed, 0x20498c69, 0x2f79cd65, 0x37be77a8,
+		0x14, 0, 0, 0, 0x1000
+	},
+	.minv = 0x2dab81e5
+};
+
+void sc25519_inv(uint8_t *r, const uint8_t *a)
+{
+	OPCOUNT(sc25519_inv);
+
+	sc25519_from_bytes(r, a, SC25519_SIZE);
+	modinv(r, r, &modinv_order);
+}
@@ -0,0 +1,43 @@
+/* Arithmetic mod the order of the Ed25519 base point
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef SC25519_H_
+#define SC25519_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Scalars are integers modulo the prime group order:
+ *
+ *     L = 2^252 + 27742317777372353535851937790883648493
+ *
+ * They are represented as 32-byte little-endian strings. Every function
+ * produces a fully reduced result (0 <= x < L), and accepts any 32-byte
+ * string as input. The pointers are not required to be distinct.
+ *
+ * This is a specialization of fprime for a single modulus. Reduction
+ * uses Barrett's method on 32-bit words, rather than fprime's generic
+ * bit-serial division. All operations have timings which are
+ * independent of input data.
+ */
+#define SC25519_SIZE  32
+
+extern const uint8_t sc25519_order[SC25519_SIZE];
+
+/* Reduce a little-endian integer of up to 64 bytes */
+void sc25519_from_bytes(uint8_t *r, const uint8_t *x, size_t len);
+
+/* Add/multiply two scalars */
+void sc25519_add(uint8_t *r, const uint8_t *a, const uint8_t *b);
+void sc25519_mul(uint8_t *r, const uint8_t *a, const uint8_t *b);
+
+/* Multiply and add, with a single reduction: s = ab + c */
+void sc25519_muladd(uint8_t *s, const uint8_t *a, const uint8_t *b,
+		    const uint8_t *c);
+
+/* Multiplicative inverse. Zero maps to zero. */
+void sc25519_inv(uint8_t *r, const uint8_t *a);
+
+#endif
@@ -56,7 +56,7 @@ static const uint64_t round_k[80] = {
 	0x5fcb6fab3ad6faecLL, 0x6c44198c4a475817LL,
 };
 
-static inline uint64_t load64(const uint8_t *x)
+static inline uint64_t load_be64(const uint8_t *x)
 {
 	uint64_t r;
 
@@ -72,7 +72,7 @@ static inline uint64_t load64(const uint8_t *x)
 	return r;
 }
 
-static inline void store64(uint8_t *x, uint64_t v)
+static inline void store_be64(uint8_t *x, uint64_t v)
 {
 	x += 7;
 	*(x--) = v;
@@ -104,7 +104,7 @@ void sha512_block(struct sha512_state *s, const uint8_t *blk)
 	int i;
 
 	for (i = 0; i < 16; i++) {
-		w[i] = load64(blk);
+		w[i] = load_be64(blk);
 		blk += 8;
 	}
 
@@ -178,7 +178,7 @@ void sha512_final(struct sha512_state *s, const uint8_t *blk,
 	}
 
 	/* Note: we assume total_size fits in 61 bits */
-	store64(temp + SHA512_BLOCK_SIZE - 8, total_size << 3);
+	store_be64(temp + SHA512_BLOCK_SIZE - 8, total_size << 3);
 	sha512_block(s, temp);
 }
 
@@ -205,7 +205,7 @@ void sha512_get(const struct sha512_state *s, uint8_t *hash,
 		if (c > len)
 			c = len;
 
-		store64(tmp, s->h[i++]);
+		store_be64(tmp, s->h[i++]);
 		memcpy(hash, tmp + offset, c);
 		len -= c;
 		hash += c;
@@ -213,7 +213,7 @@ void sha512_get(const struct sha512_state *s, uint8_t *hash,
 
 	/* Read out whole words */
 	while (len >= 8) {
-		store64(hash, s->h[i++]);
+		store_be64(hash, s->h[i++]);
 		hash += 8;
 		len -= 8;
 	}
@@ -222,7 +222,7 @@ void sha512_get(const struct sha512_state *s, uint8_t *hash,
 	if (len) {
 		uint8_t tmp[8];
 
-		store64(tmp, s->h[i]);
+		store_be64(tmp, s->h[i]);
 		memcpy(hash, tmp, len);
 	}
 }
@@ -695,6 +695,32 @@ static void test_dh(void)
 	printf("\n");
 }
 
+static void test_base_smult(void)
+{
+	uint8_t e[C25519_EXPONENT_SIZE];
+	uint8_t q1[F25519_SIZE];
+	uint8_t q2[F25519_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < sizeof(e); i++)
+		e[i] = random();
+
+	/* Unprepared exponents must give the same answer too */
+	c25519_smult(q1, c25519_base_x, e);
+	c25519_base_smult(q2, e);
+	assert(f25519_eq(q1, q2));
+
+	c25519_prepare(e);
+	c25519_smult(q1, c25519_base_x, e);
+	c25519_base_smult(q2, e);
+	assert(f25519_eq(q1, q2));
+
+	printf("  ");
+	for (i = 0; i < F25519_SIZE; i++)
+		printf("%02x", q2[i]);
+	printf("\n");
+}
+
 static void test_dh_xy(void)
 {
 	uint8_t e1[C25519_EXPONENT_SIZE];
@@ -754,6 +780,53 @@ static void test_vector(const struct test_vector *v)
 	printf("\n");
 }
 
+static void test_vectors_x4(const struct test_vector *v)
+{
+	uint8_t q[4 * F25519_SIZE];
+	uint8_t e[4 * C25519_EXPONENT_SIZE];
+	uint8_t r[4 * F25519_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < 4; i++) {
+		f25519_copy(q + i * F25519_SIZE, v[i].p);
+		f25519_copy(e + i * C25519_EXPONENT_SIZE, v[i].e);
+		c25519_prepare(e + i * C25519_EXPONENT_SIZE);
+	}
+
+	c25519_smult_x4(r, q, e);
+
+	for (i = 0; i < 4; i++)
+		assert(f25519_eq(r + i * F25519_SIZE, v[i].r));
+}
+
+static void test_smult_x4(void)
+{
+	uint8_t q[4 * F25519_SIZE];
+	uint8_t e[4 * C25519_EXPONENT_SIZE];
+	uint8_t r[4 * F25519_SIZE];
+	uint8_t s[F25519_SIZE];
+	unsigned int i;
+
+	/* Unprepared exponents and unreduced points must agree too */
+	for (i = 0; i < sizeof(q); i++)
+		q[i] = random();
+	for (i = 0; i < sizeof(e); i++)
+		e[i] = random();
+
+	c25519_smult_x4(r, q, e);
+
+	for (i = 0; i < 4; i++) {
+		c25519_smult(s, q + i * F25519_SIZE,
+			     e + i * C25519_EXPONENT_SIZE);
+		assert(f25519_eq(r + i * F25519_SIZE, s));
+	}
+
+	printf("  ");
+	for (i = 0; i < F25519_SIZE; i++)
+		printf("%02x", r[i]);
+	printf("\n");
+}
+
 static void test_vector_xy(const struct test_vector *v)
 {
 	uint8_t rx[F25519_SIZE], ry[F25519_SIZE];
@@ -786,6 +859,19 @@ int main(void)
 	for (i = 0; i < 32; i++)
 		test_vector_xy(&vectors[i]);
 
+	printf("test_vectors_x4 (%s)\n",
+	       c25519_smult_x4_native() ? "parallel" : "fallback");
+	for (i = 0; i < 32; i += 4)
+		test_vectors_x4(&vectors[i]);
+
+	printf("test_smult_x4\n");
+	for (i = 0; i < 32; i++)
+		test_smult_x4();
+
+	printf("test_base_smult\n");
+	for (i = 0; i < 32; i++)
+		test_base_smult();
+
 	printf("test_dh\n");
 	for (i = 0; i < 32; i++)
 		test_dh();
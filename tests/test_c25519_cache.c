@@ -0,0 +1,157 @@
+/* Curve25519 shared-secret cache
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "c25519_cache.h"
+
+static void random_key(uint8_t *e)
+{
+	unsigned int i;
+
+	for (i = 0; i < C25519_EXPONENT_SIZE; i++)
+		e[i] = random();
+
+	c25519_prepare(e);
+}
+
+static void random_peer(uint8_t *q)
+{
+	uint8_t e[C25519_EXPONENT_SIZE];
+
+	random_key(e);
+	c25519_base_smult(q, e);
+}
+
+static void check(struct c25519_cache *c, const uint8_t *q,
+		  const uint8_t *e, uint8_t expect_hit)
+{
+	uint8_t r1[F25519_SIZE];
+	uint8_t r2[F25519_SIZE];
+
+	assert(c25519_cache_smult(c, r1, q, e) == expect_hit);
+	c25519_smult(r2, q, e);
+	assert(f25519_eq(r1, r2));
+}
+
+static void test_hit(void)
+{
+	struct c25519_cache c;
+	uint8_t e[C25519_EXPONENT_SIZE];
+	uint8_t f[C25519_EXPONENT_SIZE];
+	uint8_t q[F25519_SIZE];
+
+	random_key(e);
+	random_key(f);
+	random_peer(q);
+
+	c25519_cache_init(&c);
+	check(&c, q, e, 0);
+	check(&c, q, e, 1);
+	check(&c, q, e, 1);
+
+	/* A different secret with the same peer is a different entry */
+	check(&c, q, f, 0);
+	check(&c, q, f, 1);
+	check(&c, q, e, 1);
+}
+
+static void test_evict(void)
+{
+	struct c25519_cache c;
+	uint8_t e[C25519_EXPONENT_SIZE];
+	uint8_t q[C25519_CACHE_ENTRIES + 1][F25519_SIZE];
+	unsigned int i;
+
+	random_key(e);
+	for (i = 0; i <= C25519_CACHE_ENTRIES; i++)
+		random_peer(q[i]);
+
+	c25519_cache_init(&c);
+	for (i = 0; i < C25519_CACHE_ENTRIES; i++)
+		check(&c, q[i], e, 0);
+
+	/* Touch the oldest entry, so that the second-oldest goes */
+	check(&c, q[0], e, 1);
+	check(&c, q[C25519_CACHE_ENTRIES], e, 0);
+
+	check(&c, q[0], e, 1);
+	check(&c, q[1], e, 0);
+
+	for (i = 3; i <= C25519_CACHE_ENTRIES; i++)
+		check(&c, q[i], e, 1);
+}
+
+/* Stamps must keep their order when the clock passes 2^32 */
+static void test_clock(void)
+{
+	struct c25519_cache c;
+	uint8_t e[C25519_EXPONENT_SIZE];
+	uint8_t q[C25519_CACHE_ENTRIES + 1][F25519_SIZE];
+	unsigned int i;
+
+	random_key(e);
+	for (i = 0; i <= C25519_CACHE_ENTRIES; i++)
+		random_peer(q[i]);
+
+	c25519_cache_init(&c);
+	c.clock = 0xffffffff - C25519_CACHE_ENTRIES / 2;
+
+	for (i = 0; i < C25519_CACHE_ENTRIES; i++)
+		check(&c, q[i], e, 0);
+	for (i = 0; i < C25519_CACHE_ENTRIES; i++)
+		check(&c, q[i], e, 1);
+
+	/* The oldest entry was stamped before the clock passed 2^32 */
+	check(&c, q[C25519_CACHE_ENTRIES], e, 0);
+	check(&c, q[0], e, 0);
+
+	for (i = 2; i <= C25519_CACHE_ENTRIES; i++)
+		check(&c, q[i], e, 1);
+}
+
+static void test_wipe(void)
+{
+	static const struct c25519_cache_entry empty;
+	struct c25519_cache c;
+	uint8_t e[C25519_EXPONENT_SIZE];
+	uint8_t q[F25519_SIZE];
+	unsigned int i;
+
+	random_key(e);
+	random_peer(q);
+
+	c25519_cache_init(&c);
+	check(&c, q, e, 0);
+	c25519_cache_wipe(&c);
+
+	for (i = 0; i < C25519_CACHE_ENTRIES; i++)
+		assert(!memcmp(&c.entries[i], &empty, sizeof(empty)));
+
+	check(&c, q, e, 0);
+}
+
+int main(void)
+{
+	int i;
+
+	srandom(0);
+
+	printf("test_hit\n");
+	for (i = 0; i < 4; i++)
+		test_hit();
+
+	printf("test_evict\n");
+	test_evict();
+
+	printf("test_clock\n");
+	test_clock();
+
+	printf("test_wipe\n");
+	test_wipe();
+
+	return 0;
+}
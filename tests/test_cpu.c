@@ -0,0 +1,67 @@
+/* Runtime CPU feature detection and backend dispatch
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "cpu.h"
+
+static void test_names(void)
+{
+	char buf[64];
+
+	assert(!cpu_feature_names(buf, sizeof(buf), 0));
+	assert(!buf[0]);
+
+	assert(cpu_feature_names(buf, sizeof(buf),
+				 CPU_BMI2 | CPU_AVX2) == 9);
+	assert(!strcmp(buf, "bmi2 avx2"));
+
+	/* Names which don't fit are dropped whole */
+	assert(cpu_feature_names(buf, 10, CPU_BMI2 | CPU_ADX |
+				 CPU_AVX2) == 8);
+	assert(!strcmp(buf, "bmi2 adx"));
+
+	assert(!cpu_feature_names(buf, 4, CPU_AVX2));
+	assert(!buf[0]);
+}
+
+static void test_dispatch(void)
+{
+	const struct cpu_dispatch *d = cpu_dispatch();
+	const char *env = getenv("C25519_PORTABLE");
+	char buf[128];
+
+	cpu_feature_names(buf, sizeof(buf), d->features);
+	printf("    features: %s\n", buf[0] ? buf : "(none)");
+	printf("    f25519: %s, ed25519: %s, c25519_x4: %s\n",
+	       d->f25519, d->ed25519, d->c25519_x4);
+
+	/* Detection happens once */
+	assert(cpu_dispatch() == d);
+	assert(cpu_features() == d->features);
+
+	assert(!strcmp(d->ed25519,
+		       (d->features & CPU_AVX2) ? "avx2" : "portable"));
+	assert(!strcmp(d->c25519_x4,
+		       (d->features & CPU_AVX2) ? "avx2" : "portable"));
+
+	if (env && *env && strcmp(env, "0")) {
+		assert(!d->features);
+		assert(!strcmp(d->f25519, "portable"));
+	}
+}
+
+int main(void)
+{
+	printf("test_names\n");
+	test_names();
+
+	printf("test_dispatch\n");
+	test_dispatch();
+
+	return 0;
+}
@@ -134,6 +134,7 @@ static const uint8_t n[FPRIME_SIZE] = {
 };
 
 static void test_mixed() {
+	struct ecdsa_pubkey pk;
 	uint8_t r[FPRIME_SIZE], s[FPRIME_SIZE];
 	uint8_t pubx[F25519_SIZE], puby[F25519_SIZE];
 	uint8_t sec[F25519_SIZE];
@@ -154,22 +155,141 @@ static void test_mixed() {
 	c25519_prepare(msg);
 
 	ecdsa_pubkey(pubx, puby, sec);
+	ecdsa_pubkey_prepare(&pk, pubx, puby);
 	assert(ecdsa_sign(r, s, sec, msg, rnd));
 	assert(ecdsa_verify(pubx, puby, msg, r, s));
+	assert(ecdsa_verify_prepared(&pk, msg, r, s));
 
 	msg[1] ^= 1;
 	assert(0 == ecdsa_verify(pubx, puby, msg, r, s));
+	assert(0 == ecdsa_verify_prepared(&pk, msg, r, s));
 	msg[1] ^= 1;
 
 	r[0] ^= 1;
 	assert(0 == ecdsa_verify(pubx, puby, msg, r, s));
+	assert(0 == ecdsa_verify_prepared(&pk, msg, r, s));
 	r[0] ^= 1;
 
 	s[31] ^= 1;
 	assert(0 == ecdsa_verify(pubx, puby, msg, r, s));
+	assert(0 == ecdsa_verify_prepared(&pk, msg, r, s));
 	s[31] ^= 1;
 }
 
+#define BATCH_COUNT	(ECDSA_BATCH_SIZE + 3)
+
+static void test_batch(void)
+{
+	uint8_t sec[BATCH_COUNT][F25519_SIZE];
+	uint8_t msg[BATCH_COUNT][F25519_SIZE];
+	uint8_t rnd[BATCH_COUNT][F25519_SIZE];
+	uint8_t pubx[BATCH_COUNT][F25519_SIZE];
+	uint8_t puby[BATCH_COUNT][F25519_SIZE];
+	uint8_t r[BATCH_COUNT][FPRIME_SIZE];
+	uint8_t s[BATCH_COUNT][FPRIME_SIZE];
+	uint8_t ok[BATCH_COUNT];
+	unsigned int i, j;
+
+	for (i = 0; i < BATCH_COUNT; i++) {
+		for (j = 0; j < F25519_SIZE; j++) {
+			sec[i][j] = random();
+			msg[i][j] = random();
+			rnd[i][j] = random();
+		}
+
+		fprime_normalize(sec[i], n);
+		fprime_normalize(rnd[i], n);
+		c25519_prepare(msg[i]);
+		ecdsa_pubkey(pubx[i], puby[i], sec[i]);
+	}
+
+	/* A k of zero mod n must fail on its own, in both chunks, and
+	 * must not write a signature which would give away the key.
+	 */
+	memset(rnd[3], 0, F25519_SIZE);
+	memcpy(rnd[ECDSA_BATCH_SIZE + 1], n, F25519_SIZE);
+	memset(r, 0xa5, sizeof(r));
+	memset(s, 0xa5, sizeof(s));
+
+	assert(ecdsa_sign_batch(ok, r[0], s[0], sec[0], msg[0], rnd[0],
+				BATCH_COUNT) == BATCH_COUNT - 2);
+
+	for (i = 0; i < BATCH_COUNT; i++) {
+		uint8_t sr[FPRIME_SIZE], ss[FPRIME_SIZE];
+
+		assert(ok[i] == ecdsa_sign(sr, ss, sec[i], msg[i], rnd[i]));
+		if (!ok[i]) {
+			for (j = 0; j < FPRIME_SIZE; j++)
+				assert(r[i][j] == 0xa5 && s[i][j] == 0xa5);
+			continue;
+		}
+
+		assert(!memcmp(sr, r[i], FPRIME_SIZE));
+		assert(!memcmp(ss, s[i], FPRIME_SIZE));
+	}
+
+	/* Replace the failed signatures with a zero s and a corrupt
+	 * message.
+	 */
+	memset(s[3], 0, FPRIME_SIZE);
+	memcpy(r[ECDSA_BATCH_SIZE + 1], r[0], FPRIME_SIZE);
+	memcpy(s[ECDSA_BATCH_SIZE + 1], s[0], FPRIME_SIZE);
+	msg[5][1] ^= 1;
+
+	assert(ecdsa_verify_batch(ok, pubx[0], puby[0], msg[0], r[0], s[0],
+				  BATCH_COUNT) == BATCH_COUNT - 3);
+
+	for (i = 0; i < BATCH_COUNT; i++)
+		assert(ok[i] == (i != 3 && i != 5 &&
+				 i != ECDSA_BATCH_SIZE + 1));
+}
+
+static void test_presig(const struct test_vector *t)
+{
+	struct ecdsa_presig_pool pool;
+	struct ecdsa_presig p;
+	uint8_t r[FPRIME_SIZE], s[FPRIME_SIZE];
+	unsigned int i;
+
+	assert(ecdsa_presign(&p, t->randm));
+	assert(ecdsa_sign_presig(r, s, t->secret, t->message_hash, &p));
+	assert(!memcmp(t->r, r, sizeof(t->r)));
+	assert(!memcmp(t->s, s, sizeof(t->s)));
+
+	/* A tuple can't be used twice */
+	assert(!ecdsa_sign_presig(r, s, t->secret, t->message_hash, &p));
+
+	/* Zero k */
+	memset(r, 0, sizeof(r));
+	assert(!ecdsa_presign(&p, r));
+	assert(!ecdsa_sign_presig(r, s, t->secret, t->message_hash, &p));
+
+	/* Fill the pool with copies, the last one marked */
+	ecdsa_presig_pool_init(&pool);
+	assert(!ecdsa_presig_pool_get(&pool, &p));
+
+	for (i = 0; i < ECDSA_PRESIG_POOL_SIZE; i++) {
+		assert(ecdsa_presign(&p, t->randm));
+		p.kinv[0] ^= (i + 1 == ECDSA_PRESIG_POOL_SIZE);
+		assert(ecdsa_presig_pool_put(&pool, &p));
+		assert(ecdsa_presig_pool_count(&pool) == i + 1);
+	}
+
+	assert(ecdsa_presign(&p, t->randm));
+	assert(!ecdsa_presig_pool_put(&pool, &p));
+
+	for (i = 0; i < ECDSA_PRESIG_POOL_SIZE; i++) {
+		assert(ecdsa_presig_pool_get(&pool, &p));
+		assert(ecdsa_sign_presig(r, s, t->secret,
+					 t->message_hash, &p));
+		assert(!memcmp(t->s, s, sizeof(t->s)) ==
+		       (i + 1 != ECDSA_PRESIG_POOL_SIZE));
+	}
+
+	assert(!ecdsa_presig_pool_get(&pool, &p));
+	assert(ecdsa_presig_pool_count(&pool) == 0);
+}
+
 static void test(const struct test_vector *t)
 {
 
@@ -218,6 +338,7 @@ int main(void)
 
 	for (i = 0; i < NUM_VECTORS; i++) {
 		test(&test_vectors[i]);
+		test_presig(&test_vectors[i]);
 		printf("\n");
 	}
 
@@ -225,5 +346,7 @@ int main(void)
 		test_mixed();
 	}
 
+	test_batch();
+
 	return 0;
 }
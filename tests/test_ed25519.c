@@ -93,6 +93,159 @@ static void test_pack(void)
 	print_point(x1, y1);
 }
 
+static void test_smult_base(void)
+{
+	uint8_t e[ED25519_EXPONENT_SIZE];
+	uint8_t x1[F25519_SIZE];
+	uint8_t y1[F25519_SIZE];
+	uint8_t x2[F25519_SIZE];
+	uint8_t y2[F25519_SIZE];
+	struct ed25519_pt p;
+	int i;
+
+	for (i = 0; i < ED25519_EXPONENT_SIZE; i++)
+		e[i] = random();
+
+	ed25519_smult(&p, &ed25519_base, e);
+	ed25519_unproject(x1, y1, &p);
+
+	ed25519_smult_base(&p, e);
+	ed25519_unproject(x2, y2, &p);
+
+	assert(f25519_eq(x1, x2));
+	assert(f25519_eq(y1, y2));
+
+	print_point(x2, y2);
+}
+
+static void test_smult_window(void)
+{
+	uint8_t e[ED25519_EXPONENT_SIZE];
+	uint8_t x1[F25519_SIZE];
+	uint8_t y1[F25519_SIZE];
+	uint8_t x2[F25519_SIZE];
+	uint8_t y2[F25519_SIZE];
+	struct ed25519_window w;
+	struct ed25519_pt q;
+	struct ed25519_pt p;
+	int i;
+
+	for (i = 0; i < ED25519_EXPONENT_SIZE; i++)
+		e[i] = random();
+
+	ed25519_smult(&q, &ed25519_base, e);
+
+	for (i = 0; i < ED25519_EXPONENT_SIZE; i++)
+		e[i] = random();
+
+	ed25519_smult(&p, &q, e);
+	ed25519_unproject(x1, y1, &p);
+
+	ed25519_window_init(&w, &q);
+	ed25519_smult_window(&p, &w, e);
+	ed25519_unproject(x2, y2, &p);
+
+	assert(f25519_eq(x1, x2));
+	assert(f25519_eq(y1, y2));
+}
+
+static void test_smult_vartime(int fill)
+{
+	uint8_t e[ED25519_EXPONENT_SIZE];
+	uint8_t x1[F25519_SIZE];
+	uint8_t y1[F25519_SIZE];
+	uint8_t x2[F25519_SIZE];
+	uint8_t y2[F25519_SIZE];
+	struct ed25519_pt q;
+	struct ed25519_pt p;
+	int i;
+
+	for (i = 0; i < ED25519_EXPONENT_SIZE; i++)
+		e[i] = random();
+
+	ed25519_smult(&q, &ed25519_base, e);
+
+	for (i = 0; i < ED25519_EXPONENT_SIZE; i++)
+		e[i] = (fill < 0) ? random() : fill;
+
+	ed25519_smult(&p, &q, e);
+	ed25519_unproject(x1, y1, &p);
+
+	ed25519_smult_vartime(&p, &q, e);
+	ed25519_unproject(x2, y2, &p);
+
+	assert(f25519_eq(x1, x2));
+	assert(f25519_eq(y1, y2));
+}
+
+/* Double-and-add using only the byte-oriented point operations */
+static void smult_ref(struct ed25519_pt *r, const struct ed25519_pt *p,
+		      const uint8_t *e)
+{
+	int i;
+
+	ed25519_copy(r, &ed25519_neutral);
+
+	for (i = 255; i >= 0; i--) {
+		ed25519_double(r, r);
+		if ((e[i >> 3] >> (i & 7)) & 1)
+			ed25519_add(r, r, p);
+	}
+}
+
+/* Cross-check the 4-way backend against the byte-oriented code */
+static void test_x4(void)
+{
+	uint8_t e[ED25519_EXPONENT_SIZE];
+	uint8_t nibble[ED25519_EXPONENT_SIZE * 2];
+	uint8_t x1[F25519_SIZE];
+	uint8_t y1[F25519_SIZE];
+	uint8_t x2[F25519_SIZE];
+	uint8_t y2[F25519_SIZE];
+	struct ed25519_window w;
+	struct ed25519_pt q;
+	struct ed25519_pt p;
+	int i;
+
+	for (i = 0; i < ED25519_EXPONENT_SIZE; i++)
+		e[i] = random();
+
+	smult_ref(&q, &ed25519_base, e);
+
+	for (i = 0; i < ED25519_EXPONENT_SIZE; i++)
+		e[i] = random();
+
+	smult_ref(&p, &q, e);
+	ed25519_unproject(x1, y1, &p);
+
+	if (!ed25519_x4_smult(&p, &q, e))
+		return;
+
+	ed25519_unproject(x2, y2, &p);
+	assert(f25519_eq(x1, x2));
+	assert(f25519_eq(y1, y2));
+
+	ed25519_smult_vartime(&p, &q, e);
+	ed25519_unproject(x2, y2, &p);
+	assert(f25519_eq(x1, x2));
+	assert(f25519_eq(y1, y2));
+
+	for (i = 0; i < ED25519_EXPONENT_SIZE * 2; i++) {
+		const int k = ED25519_EXPONENT_SIZE * 2 - 1 - i;
+
+		nibble[i] = (e[k >> 1] >> ((k & 1) << 2)) & 15;
+	}
+
+	ed25519_window_init(&w, &q);
+	assert(ed25519_x4_smult_niels(&p, w.p, 1 << ED25519_WINDOW_BITS,
+				      nibble, sizeof(nibble),
+				      ED25519_WINDOW_BITS));
+
+	ed25519_unproject(x2, y2, &p);
+	assert(f25519_eq(x1, x2));
+	assert(f25519_eq(y1, y2));
+}
+
 static void test_dh(void)
 {
 	uint8_t e1[ED25519_EXPONENT_SIZE];
@@ -146,6 +299,7 @@ static void test_dh(void)
 static void test_add(void)
 {
 	struct ed25519_pt p;
+	struct ed25519_pt q;
 	uint8_t ax[F25519_SIZE];
 	uint8_t ay[F25519_SIZE];
 	uint8_t bx[F25519_SIZE];
@@ -170,6 +324,40 @@ static void test_add(void)
 
 	assert(f25519_eq(ax, bx));
 	assert(f25519_eq(ay, by));
+
+	/* The base point scaled by 37, with Z stored as 2^256 - 1 */
+	printf("  relaxed\n");
+	f25519_mul_c(q.x, ed25519_base.x, 37);
+	f25519_mul_c(q.y, ed25519_base.y, 37);
+	f25519_mul_c(q.t, ed25519_base.t, 37);
+	memset(q.z, 0xff, F25519_SIZE);
+
+	ed25519_add(&p, &ed25519_base, &q);
+	ed25519_unproject(bx, by, &p);
+	assert(f25519_eq(ax, bx));
+	assert(f25519_eq(ay, by));
+
+	ed25519_double(&p, &q);
+	ed25519_unproject(bx, by, &p);
+	assert(f25519_eq(ax, bx));
+	assert(f25519_eq(ay, by));
+}
+
+static void test_cswap(void)
+{
+	struct ed25519_pt a;
+	struct ed25519_pt b;
+
+	ed25519_copy(&a, &ed25519_base);
+	ed25519_copy(&b, &ed25519_neutral);
+
+	ed25519_pt_cswap(&a, &b, 0);
+	assert(!memcmp(&a, &ed25519_base, sizeof(a)));
+	assert(!memcmp(&b, &ed25519_neutral, sizeof(b)));
+
+	ed25519_pt_cswap(&a, &b, 1);
+	assert(!memcmp(&a, &ed25519_neutral, sizeof(a)));
+	assert(!memcmp(&b, &ed25519_base, sizeof(b)));
 }
 
 static void test_order(void)
@@ -207,6 +395,9 @@ int main(void)
 	printf("test_double_add\n");
 	test_add();
 
+	printf("test_cswap\n");
+	test_cswap();
+
 	printf("test_order\n");
 	test_order();
 
@@ -214,6 +405,25 @@ int main(void)
 	for (i = 0; i < 20; i++)
 		test_pack();
 
+	printf("test_smult_base\n");
+	for (i = 0; i < 20; i++)
+		test_smult_base();
+
+	printf("test_smult_window\n");
+	for (i = 0; i < 20; i++)
+		test_smult_window();
+
+	printf("test_smult_vartime\n");
+	test_smult_vartime(0x00);
+	test_smult_vartime(0xff);
+	test_smult_vartime(0x55);
+	for (i = 0; i < 20; i++)
+		test_smult_vartime(-1);
+
+	printf("test_x4 (native: %d)\n", !!ed25519_x4_native());
+	for (i = 0; i < 20; i++)
+		test_x4();
+
 	printf("test_dh\n");
 	for (i = 0; i < 10; i++)
 		test_dh();
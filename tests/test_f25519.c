@@ -6,6 +6,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include "f25519.h"
 
@@ -96,6 +97,107 @@ static void test_add_sub(void)
 	assert(f25519_eq(x, b));
 }
 
+static void test_cswap(void)
+{
+	uint8_t a[F25519_SIZE];
+	uint8_t b[F25519_SIZE];
+	uint8_t x[F25519_SIZE];
+	uint8_t y[F25519_SIZE];
+
+	randomize(a);
+	randomize(b);
+
+	memcpy(x, a, sizeof(x));
+	memcpy(y, b, sizeof(y));
+
+	f25519_cswap(x, y, 0);
+	assert(!memcmp(x, a, sizeof(x)));
+	assert(!memcmp(y, b, sizeof(y)));
+
+	f25519_cswap(x, y, 1);
+	assert(!memcmp(x, b, sizeof(x)));
+	assert(!memcmp(y, a, sizeof(y)));
+}
+
+static void test_lookup(void)
+{
+	/* An odd entry size, to exercise the byte-wise tail */
+	uint8_t table[7][F25519_SIZE + 3];
+	uint8_t r[F25519_SIZE + 3];
+	unsigned int i;
+	unsigned int j;
+
+	for (i = 0; i < 7; i++)
+		for (j = 0; j < sizeof(table[i]); j++)
+			table[i][j] = random();
+
+	for (i = 0; i < 7; i++) {
+		memset(r, 0xaa, sizeof(r));
+		f25519_lookup(r, table, sizeof(r), 7, i);
+		assert(!memcmp(r, table[i], sizeof(r)));
+	}
+
+	memset(r, 0xaa, sizeof(r));
+	f25519_lookup(r, table, sizeof(r), 7, 7);
+	for (j = 0; j < sizeof(r); j++)
+		assert(!r[j]);
+}
+
+/* 2p - 1, the largest un-normalized element */
+static const uint8_t max_elem[F25519_SIZE] = {
+	0xd9, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+static void test_add_lazy(int extreme)
+{
+	uint8_t a[F25519_SIZE];
+	uint8_t b[F25519_SIZE];
+	uint8_t c[F25519_SIZE];
+	uint8_t d[F25519_SIZE];
+	uint8_t e[F25519_SIZE];
+	uint8_t f[F25519_SIZE];
+
+	/* Un-normalized inputs, below 2p, or one relaxed input */
+	if (extreme == 2) {
+		memset(a, 0xff, F25519_SIZE);
+		f25519_copy(b, max_elem);
+	} else if (extreme) {
+		f25519_copy(a, max_elem);
+		f25519_copy(b, max_elem);
+	} else {
+		randomize(c);
+		randomize(d);
+		f25519_add(a, c, f25519_zero);
+		f25519_add(b, d, f25519_zero);
+	}
+
+	randomize(e);
+
+	f25519_add(c, a, b);
+	f25519_add__lazy(d, a, b);
+
+	/* The relaxed result multiplies correctly... */
+	f25519_mul__distinct(f, d, e);
+	f25519_mul__distinct(d, c, e);
+	f25519_normalize(d);
+	f25519_normalize(f);
+	assert(f25519_eq(d, f));
+
+	/* ... and normalizes correctly */
+	f25519_add__lazy(d, a, b);
+	f25519_normalize(c);
+	f25519_normalize(d);
+	assert(f25519_eq(c, d));
+
+	/* Aliased */
+	f25519_add__lazy(a, a, b);
+	f25519_normalize(a);
+	assert(f25519_eq(a, c));
+}
+
 static void test_mul_c(void)
 {
 	uint8_t a[F25519_SIZE];
@@ -137,6 +239,63 @@ static void test_mul(void)
 	assert(f25519_eq(d, e));
 }
 
+/* Compare a backend against the byte-oriented code. Inputs are full
+ * 256-bit strings, optionally saturated, and squarings pass the same
+ * pointer twice.
+ */
+static void test_backend(f25519_mul_fn fn, int fill)
+{
+	const f25519_mul_fn ref = f25519_mul_backend("portable");
+	uint8_t a[F25519_SIZE];
+	uint8_t b[F25519_SIZE];
+	uint8_t c[F25519_SIZE];
+	uint8_t d[F25519_SIZE];
+
+	randomize(a);
+	randomize(b);
+
+	if (fill >= 0) {
+		memset(a, fill, sizeof(a));
+		memset(b, fill, sizeof(b));
+	}
+
+	ref(c, a, b);
+	fn(d, a, b);
+	f25519_normalize(c);
+	f25519_normalize(d);
+	assert(f25519_eq(c, d));
+
+	ref(c, a, a);
+	fn(d, a, a);
+	f25519_normalize(c);
+	f25519_normalize(d);
+	assert(f25519_eq(c, d));
+}
+
+static void test_backends(void)
+{
+	static const char *const names[] = {"radix51", "mulx"};
+	unsigned int i;
+
+	assert(f25519_mul_backend("portable"));
+	assert(!f25519_mul_backend("none"));
+
+	for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		const f25519_mul_fn fn = f25519_mul_backend(names[i]);
+		int j;
+
+		printf("    %s: %s\n", names[i], fn ? "yes" : "unavailable");
+		if (!fn)
+			continue;
+
+		test_backend(fn, 0x00);
+		test_backend(fn, 0xff);
+		test_backend(fn, 0x7f);
+		for (j = 0; j < 1000; j++)
+			test_backend(fn, -1);
+	}
+}
+
 static void test_distributive(void)
 {
 	uint8_t a[F25519_SIZE];
@@ -232,6 +391,20 @@ int main(void)
 	for (i = 0; i < 100; i++)
 		test_add_sub();
 
+	printf("test_cswap\n");
+	for (i = 0; i < 100; i++)
+		test_cswap();
+
+	printf("test_lookup\n");
+	for (i = 0; i < 100; i++)
+		test_lookup();
+
+	printf("test_add_lazy\n");
+	test_add_lazy(1);
+	test_add_lazy(2);
+	for (i = 0; i < 100; i++)
+		test_add_lazy(0);
+
 	printf("test_mul_c\n");
 	for (i = 0; i < 100; i++)
 		test_mul_c();
@@ -240,6 +413,9 @@ int main(void)
 	for (i = 0; i < 100; i++)
 		test_mul();
 
+	printf("test_backends\n");
+	test_backends();
+
 	printf("test_distributive\n");
 	for (i = 0; i < 100; i++)
 		test_distributive();
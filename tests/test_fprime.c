@@ -17,6 +17,20 @@ static const uint8_t modulus[FPRIME_SIZE] = {
 	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
 };
 
+/* 2^255 - 19 */
+static const uint8_t modulus_25519[FPRIME_SIZE] = {
+	0xed, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f
+};
+
+/* 2^127 - 1 */
+static const uint8_t modulus_127[FPRIME_SIZE] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f
+};
+
 static void randomize(uint8_t *x)
 {
 	int i;
@@ -116,6 +130,132 @@ static void test_mul(void)
 	assert(fprime_eq(fc, fd));
 }
 
+/* Reference multiplication by binary double-and-add */
+static void slow_mul(uint8_t *r, const uint8_t *a, const uint8_t *b,
+		     const uint8_t *m)
+{
+	int i;
+
+	memset(r, 0, FPRIME_SIZE);
+
+	for (i = FPRIME_SIZE * 8 - 1; i >= 0; i--) {
+		uint8_t t[FPRIME_SIZE];
+
+		fprime_copy(t, r);
+		fprime_add(r, t, m);
+
+		if ((b[i >> 3] >> (i & 7)) & 1)
+			fprime_add(r, a, m);
+	}
+}
+
+static void test_mul_modulus(const uint8_t *m)
+{
+	struct fprime_ctx ctx;
+	uint8_t a[FPRIME_SIZE];
+	uint8_t b[FPRIME_SIZE];
+	uint8_t x[FPRIME_SIZE];
+	uint8_t y[FPRIME_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < FPRIME_SIZE; i++) {
+		a[i] = random();
+		b[i] = random();
+	}
+
+	fprime_normalize(a, m);
+	fprime_normalize(b, m);
+
+	slow_mul(x, a, b, m);
+	fprime_mul(y, a, b, m);
+	assert(fprime_eq(x, y));
+
+	fprime_ctx_init(&ctx, m);
+	fprime_ctx_mul(y, a, b, &ctx);
+	assert(fprime_eq(x, y));
+
+	/* Aliased and unreduced operands */
+	b[31] |= 0x80;
+	fprime_copy(x, b);
+	fprime_normalize(x, m);
+	slow_mul(y, a, x, m);
+	fprime_ctx_mul(b, a, b, &ctx);
+	assert(fprime_eq(b, y));
+}
+
+static void test_inv_modulus(const uint8_t *m)
+{
+	uint8_t a[FPRIME_SIZE];
+	uint8_t ai[FPRIME_SIZE];
+	uint8_t p[FPRIME_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < FPRIME_SIZE; i++)
+		a[i] = random();
+
+	fprime_normalize(a, m);
+	fprime_inv(ai, a, m);
+	fprime_mul(p, a, ai, m);
+
+	assert(fprime_eq(p, fprime_one));
+}
+
+static void test_ctx_modulus(const uint8_t *m)
+{
+	struct fprime_ctx ctx;
+	uint8_t x[64];
+	uint8_t a[FPRIME_SIZE];
+	uint8_t b[FPRIME_SIZE];
+	uint8_t c[FPRIME_SIZE];
+	uint8_t d[FPRIME_SIZE];
+	const size_t len = random() % (sizeof(x) + 1);
+	unsigned int i;
+
+	for (i = 0; i < sizeof(x); i++)
+		x[i] = random();
+
+	fprime_ctx_init(&ctx, m);
+
+	fprime_from_bytes(a, x, len, m);
+	fprime_ctx_from_bytes(b, x, len, &ctx);
+	assert(fprime_eq(a, b));
+
+	fprime_copy(a, x);
+	fprime_normalize(a, m);
+	fprime_copy(b, x);
+	fprime_ctx_normalize(b, &ctx);
+	assert(fprime_eq(a, b));
+
+	fprime_copy(b, x + FPRIME_SIZE);
+	fprime_normalize(b, m);
+
+	fprime_copy(c, a);
+	fprime_add(c, b, m);
+	fprime_copy(d, a);
+	fprime_ctx_add(d, b, &ctx);
+	assert(fprime_eq(c, d));
+
+	fprime_copy(c, a);
+	fprime_sub(c, b, m);
+	fprime_copy(d, a);
+	fprime_ctx_sub(d, b, &ctx);
+	assert(fprime_eq(c, d));
+
+	/* Aliased operands */
+	fprime_copy(c, a);
+	fprime_add(c, a, m);
+	fprime_copy(d, a);
+	fprime_ctx_add(d, d, &ctx);
+	assert(fprime_eq(c, d));
+
+	fprime_ctx_sub(d, d, &ctx);
+	assert(fprime_eq(d, fprime_zero));
+
+	fprime_inv(c, a, m);
+	fprime_ctx_inv(d, a, &ctx);
+	assert(fprime_eq(c, d));
+}
+
 static void test_distributive(void)
 {
 	uint8_t a[FPRIME_SIZE];
@@ -206,6 +346,20 @@ int main(void)
 	for (i = 0; i < 100; i++)
 		test_mul();
 
+	printf("test_mul_modulus\n");
+	for (i = 0; i < 100; i++) {
+		test_mul_modulus(modulus);
+		test_mul_modulus(modulus_25519);
+		test_mul_modulus(modulus_127);
+	}
+
+	printf("test_ctx_modulus\n");
+	for (i = 0; i < 100; i++) {
+		test_ctx_modulus(modulus);
+		test_ctx_modulus(modulus_25519);
+		test_ctx_modulus(modulus_127);
+	}
+
 	printf("test_distributive\n");
 	for (i = 0; i < 100; i++)
 		test_distributive();
@@ -214,5 +368,12 @@ int main(void)
 	for (i = 0; i < 10; i++)
 		test_inv();
 
+	printf("test_inv_modulus\n");
+	for (i = 0; i < 10; i++) {
+		test_inv_modulus(modulus);
+		test_inv_modulus(modulus_25519);
+		test_inv_modulus(modulus_127);
+	}
+
 	return 0;
 }
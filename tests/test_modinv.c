@@ -0,0 +1,162 @@
+/* Constant-time modular inversion
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "modinv.h"
+#include "f25519.h"
+#include "fprime.h"
+
+/* 2^252 + 27742317777372353535851937790883648493 */
+static const uint8_t order[MODINV_SIZE] = {
+	0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+	0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+};
+
+/* 2^255 - 19 */
+static const uint8_t modulus_25519[MODINV_SIZE] = {
+	0xed, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f
+};
+
+/* 2^256 - 189 */
+static const uint8_t modulus_256[MODINV_SIZE] = {
+	0x43, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+/* 65537 */
+static const uint8_t modulus_small[MODINV_SIZE] = {
+	0x01, 0x00, 0x01
+};
+
+static void randomize(uint8_t *x)
+{
+	int i;
+
+	for (i = 0; i < MODINV_SIZE; i++)
+		x[i] = random();
+}
+
+static void test_zero(const uint8_t *modulus)
+{
+	struct modinv_ctx ctx;
+	uint8_t x[MODINV_SIZE];
+
+	modinv_init(&ctx, modulus);
+	memset(x, 0xff, sizeof(x));
+	modinv(x, fprime_zero, &ctx);
+	assert(fprime_eq(x, fprime_zero));
+}
+
+static void test_inv(const uint8_t *modulus)
+{
+	struct modinv_ctx ctx;
+	uint8_t a[MODINV_SIZE];
+	uint8_t b[MODINV_SIZE];
+	uint8_t c[MODINV_SIZE];
+	uint8_t d[MODINV_SIZE];
+
+	modinv_init(&ctx, modulus);
+
+	/* Unreduced input */
+	randomize(a);
+	modinv(b, a, &ctx);
+
+	fprime_from_bytes(c, a, sizeof(a), modulus);
+	if (fprime_eq(c, fprime_zero))
+		return;
+
+	/* Result is fully reduced */
+	fprime_copy(d, b);
+	fprime_normalize(d, modulus);
+	assert(fprime_eq(b, d));
+
+	fprime_mul(d, b, c, modulus);
+	assert(fprime_eq(d, fprime_one));
+
+	/* Aliased output, reduced input */
+	modinv(c, c, &ctx);
+	assert(fprime_eq(b, c));
+}
+
+static void test_f25519(void)
+{
+	uint8_t a[F25519_SIZE];
+	uint8_t b[F25519_SIZE];
+	uint8_t c[F25519_SIZE];
+
+	randomize(a);
+	f25519_inv__distinct(b, a);
+	f25519_mul__distinct(c, a, b);
+	f25519_normalize(c);
+	assert(f25519_eq(c, f25519_one));
+}
+
+static void test_f25519_zero(void)
+{
+	static const uint8_t zeros[][F25519_SIZE] = {
+		/* p */
+		{
+			0xed, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+			0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+			0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+			0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f
+		},
+		/* 2p */
+		{
+			0xda, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+			0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+			0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+			0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+		},
+		{0}
+	};
+	uint8_t r[F25519_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < sizeof(zeros) / sizeof(zeros[0]); i++) {
+		f25519_inv(r, zeros[i]);
+		assert(f25519_eq(r, f25519_zero));
+	}
+}
+
+int main(void)
+{
+	int i;
+
+	srandom(0);
+
+	printf("test_zero\n");
+	test_zero(order);
+	test_zero(modulus_25519);
+	test_zero(modulus_256);
+	test_zero(modulus_small);
+
+	printf("test_inv\n");
+	for (i = 0; i < 1000; i++) {
+		test_inv(order);
+		test_inv(modulus_25519);
+		test_inv(modulus_256);
+		test_inv(modulus_small);
+	}
+
+	printf("test_f25519\n");
+	for (i = 0; i < 1000; i++)
+		test_f25519();
+
+	printf("test_f25519_zero\n");
+	test_f25519_zero();
+
+	return 0;
+}
@@ -105,6 +105,13 @@ static void test_sm(void)
 	uint8_t wy[F25519_SIZE];
 	morph25519_e2w(wx, wy, ex, ey);
 	test_morph_wx2wy(wy, wx);
+
+	/* Projective comparison, with the point still unnormalized */
+	assert(morph25519_wx_eq_ey(wx, p.y, p.z));
+	wx[0] ^= 1;
+	assert(!morph25519_wx_eq_ey(wx, p.y, p.z));
+	assert(!morph25519_wx_eq_ey(wx, ed25519_neutral.y,
+				    ed25519_neutral.z));
 }
 
 int main(void)
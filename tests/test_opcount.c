@@ -0,0 +1,86 @@
+/* Counting of field operations
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "opcount.h"
+#include "f25519.h"
+#include "c25519.h"
+
+static void test_mul(void)
+{
+	uint8_t a[F25519_SIZE] = {3};
+	uint8_t b[F25519_SIZE] = {5};
+	uint8_t r[F25519_SIZE];
+	struct opcount c;
+
+	opcount_reset();
+	f25519_mul__distinct(r, a, b);
+	f25519_mul(r, r, b);
+	f25519_mul__distinct(r, a, a);
+	f25519_add(r, a, b);
+	f25519_inv__distinct(r, a);
+	opcount_snapshot(&c);
+
+	assert(c.f25519_mul == 2);
+	assert(c.f25519_sqr == 1);
+	assert(c.f25519_add == 1);
+	assert(c.f25519_inv == 1);
+	assert(!c.f25519_sub);
+
+	opcount_reset();
+	opcount_snapshot(&c);
+	assert(!c.f25519_mul);
+	assert(!c.f25519_sqr);
+	assert(!c.f25519_add);
+	assert(!c.f25519_inv);
+}
+
+/* The profile of the Montgomery ladder. Per bit, the differential
+ * addition takes 4M + 2S and the doubling 2M + 3S + 2C, for bits 254
+ * to 0. Then one inversion and a multiplication.
+ */
+static void test_ladder(void)
+{
+	uint8_t e[C25519_EXPONENT_SIZE];
+	uint8_t r[F25519_SIZE];
+	struct opcount c;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(e); i++)
+		e[i] = random();
+	c25519_prepare(e);
+
+	opcount_reset();
+	c25519_smult(r, c25519_base_x, e);
+	opcount_snapshot(&c);
+
+	printf("  %luM %luS %luC %lu+ %lu- %luI\n",
+	       c.f25519_mul, c.f25519_sqr, c.f25519_mul_c,
+	       c.f25519_add + c.f25519_add_lazy, c.f25519_sub,
+	       c.f25519_inv);
+
+	assert(c.f25519_mul == 255 * 6 + 1);
+	assert(c.f25519_sqr == 255 * 5);
+	assert(c.f25519_mul_c == 255 * 2);
+	assert(c.f25519_inv == 1);
+}
+
+int main(void)
+{
+	if (!opcount_enabled()) {
+		printf("opcount: not enabled in this build\n");
+		return 1;
+	}
+
+	printf("test_mul\n");
+	test_mul();
+
+	printf("test_ladder\n");
+	test_ladder();
+
+	return 0;
+}
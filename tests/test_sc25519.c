@@ -0,0 +1,137 @@
+/* Arithmetic mod the order of the Ed25519 base point
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "sc25519.h"
+#include "fprime.h"
+
+static void randomize(uint8_t *x, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		x[i] = random();
+}
+
+static void test_from_bytes(void)
+{
+	uint8_t x[64];
+	uint8_t a[SC25519_SIZE];
+	uint8_t b[FPRIME_SIZE];
+	size_t len;
+
+	randomize(x, sizeof(x));
+
+	for (len = 0; len <= sizeof(x); len++) {
+		sc25519_from_bytes(a, x, len);
+		fprime_from_bytes(b, x, len, sc25519_order);
+		assert(fprime_eq(a, b));
+	}
+}
+
+static void test_edges(void)
+{
+	uint8_t x[64];
+	uint8_t a[SC25519_SIZE];
+	uint8_t b[FPRIME_SIZE];
+
+	/* L reduces to zero */
+	sc25519_from_bytes(a, sc25519_order, SC25519_SIZE);
+	assert(fprime_eq(a, fprime_zero));
+
+	/* The largest inputs */
+	memset(x, 0xff, sizeof(x));
+	sc25519_from_bytes(a, x, sizeof(x));
+	fprime_from_bytes(b, x, sizeof(x), sc25519_order);
+	assert(fprime_eq(a, b));
+
+	sc25519_muladd(a, x, x, x);
+	fprime_from_bytes(b, x, SC25519_SIZE, sc25519_order);
+	fprime_mul(x, b, b, sc25519_order);
+	fprime_add(x, b, sc25519_order);
+	assert(fprime_eq(a, x));
+
+	/* L - 1 */
+	memcpy(x, sc25519_order, SC25519_SIZE);
+	x[0]--;
+	sc25519_from_bytes(a, x, SC25519_SIZE);
+	assert(fprime_eq(a, x));
+}
+
+static void test_inv_zero(void)
+{
+	uint8_t x[SC25519_SIZE];
+
+	sc25519_inv(x, sc25519_order);
+	assert(fprime_eq(x, fprime_zero));
+}
+
+static void test_arith(void)
+{
+	uint8_t a[SC25519_SIZE];
+	uint8_t b[SC25519_SIZE];
+	uint8_t c[SC25519_SIZE];
+	uint8_t na[FPRIME_SIZE];
+	uint8_t nb[FPRIME_SIZE];
+	uint8_t nc[FPRIME_SIZE];
+	uint8_t x[SC25519_SIZE];
+	uint8_t y[FPRIME_SIZE];
+
+	/* Unreduced inputs */
+	randomize(a, sizeof(a));
+	randomize(b, sizeof(b));
+	randomize(c, sizeof(c));
+
+	fprime_from_bytes(na, a, sizeof(a), sc25519_order);
+	fprime_from_bytes(nb, b, sizeof(b), sc25519_order);
+	fprime_from_bytes(nc, c, sizeof(c), sc25519_order);
+
+	sc25519_add(x, a, b);
+	fprime_copy(y, na);
+	fprime_add(y, nb, sc25519_order);
+	assert(fprime_eq(x, y));
+
+	sc25519_mul(x, a, b);
+	fprime_mul(y, na, nb, sc25519_order);
+	assert(fprime_eq(x, y));
+
+	sc25519_muladd(x, a, b, c);
+	fprime_add(y, nc, sc25519_order);
+	assert(fprime_eq(x, y));
+
+	/* Aliased output */
+	sc25519_muladd(a, a, b, c);
+	assert(fprime_eq(a, y));
+
+	/* Inverse of an unreduced input, with aliased output */
+	fprime_inv(y, nb, sc25519_order);
+	sc25519_inv(b, b);
+	assert(fprime_eq(b, y));
+}
+
+int main(void)
+{
+	int i;
+
+	srandom(0);
+
+	printf("test_from_bytes\n");
+	for (i = 0; i < 100; i++)
+		test_from_bytes();
+
+	printf("test_inv_zero\n");
+	test_inv_zero();
+
+	printf("test_edges\n");
+	test_edges();
+
+	printf("test_arith\n");
+	for (i = 0; i < 1000; i++)
+		test_arith();
+
+	return 0;
+}
@@ -0,0 +1,116 @@
+#!/bin/sh
+# Generate a single-file build of the package
+#
+# This file is in the public domain.
+#
+# Usage: tools/amalgamate.sh [-h] <srcdir>
+#
+# Without -h, writes c25519_all.c to stdout: every header and source file
+# in <srcdir>, with local includes expanded once, forming one translation
+# unit which may be compiled in place of the separate objects.
+#
+# With -h, writes the header-only form, c25519_all.h. Every file which
+# includes it sees the declarations; the one which defines
+# C25519_IMPLEMENTATION before including it also gets the definitions.
+#
+# In both forms, the field layer (f25519) is made static inline, unless
+# F25519_API is defined beforehand.
+
+header_only=0
+if [ "$1" = "-h" ]; then
+	header_only=1
+	shift
+fi
+
+if [ $# -ne 1 ] || [ ! -d "$1" ]; then
+	echo "usage: $0 [-h] <srcdir>" >&2
+	exit 1
+fi
+
+src=$1
+headers=$(ls "$src"/*.h | grep -v '/fe4\.h$')
+sources=$(ls "$src"/*.c)
+
+awk -v dir="$src" -v header_only="$header_only" \
+    -v headers="$headers" -v sources="$sources" '
+# Copy a file, expanding each local include the first time it is seen
+function emit(path,    line, name) {
+	print "/*** begin " substr(path, length(dir) + 2) " ***/"
+
+	while ((getline line < path) > 0) {
+		if (line ~ /^#include "[^"]*"/) {
+			name = line
+			sub(/^#include "/, "", name)
+			sub(/".*/, "", name)
+
+			if (!(name in seen)) {
+				seen[name] = 1
+				emit(dir "/" name)
+			}
+		} else {
+			print line
+		}
+	}
+
+	close(path)
+	print "/*** end " substr(path, length(dir) + 2) " ***/"
+}
+
+function emit_list(list,    n, files, i, name) {
+	n = split(list, files, "\n")
+
+	for (i = 1; i <= n; i++) {
+		name = substr(files[i], length(dir) + 2)
+
+		if (!(name in seen)) {
+			seen[name] = 1
+			emit(files[i])
+		}
+	}
+}
+
+BEGIN {
+	if (header_only) {
+		print "/* Curve25519, Ed25519 and ECDSA-Wei25519, header-only"
+		print " *"
+		print " * Generated by tools/amalgamate.sh. Do not edit."
+		print " *"
+		print " * Include this file wherever the API is used. In exactly one"
+		print " * of those files, define C25519_IMPLEMENTATION first."
+		print " *"
+		print " * This file is in the public domain."
+		print " */"
+		print ""
+		print "#ifndef C25519_ALL_H_"
+		print "#define C25519_ALL_H_"
+		print ""
+		print "#if defined(C25519_IMPLEMENTATION) && !defined(F25519_API)"
+		print "#define F25519_API static inline"
+		print "#endif"
+		print ""
+		emit_list(headers)
+		print ""
+		print "#endif /* C25519_ALL_H_ */"
+		print ""
+		print "#if defined(C25519_IMPLEMENTATION) && !defined(C25519_ALL_IMPL_)"
+		print "#define C25519_ALL_IMPL_"
+		print ""
+		emit_list(sources)
+		print ""
+		print "#endif /* C25519_IMPLEMENTATION */"
+	} else {
+		print "/* Curve25519, Ed25519 and ECDSA-Wei25519, as one translation unit"
+		print " *"
+		print " * Generated by tools/amalgamate.sh. Do not edit."
+		print " *"
+		print " * This file is in the public domain."
+		print " */"
+		print ""
+		print "#ifndef F25519_API"
+		print "#define F25519_API static inline"
+		print "#endif"
+		print ""
+		emit_list(headers)
+		emit_list(sources)
+	}
+}'
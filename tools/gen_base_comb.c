@@ -0,0 +1,73 @@
+/* Generate the fixed-base comb table for ed25519_smult_base()
+ *
+ * This file is in the public domain.
+ *
+ * Prints the definition of base_comb[] exactly as it appears in
+ * src/ed25519.c. "make check" compares the two, so the table in the
+ * source can't drift from the arithmetic which defines it. To change
+ * the table, paste this program's output over the old definition.
+ */
+
+#include <stdio.h>
+#include "ed25519.h"
+
+#define TEETH    4
+#define SPACING  64
+
+static void print_elem(const char *name, const uint8_t *x, int last)
+{
+	int i;
+
+	printf("\t\t.%s = {\n", name);
+
+	for (i = 0; i < F25519_SIZE; i++)
+		printf("%s0x%02x%s", (i & 7) ? " " : "\t\t\t", x[i],
+		       (i == F25519_SIZE - 1) ? "\n" :
+		       ((i & 7) == 7) ? ",\n" : ",");
+
+	printf("\t\t}%s\n", last ? "" : ",");
+}
+
+int main(void)
+{
+	struct ed25519_pt tooth[TEETH];
+	struct ed25519_pt p[1 << TEETH];
+	struct ed25519_pt_niels n[1 << TEETH];
+	int i, j;
+
+	/* tooth[i] = 2^(64i) B */
+	ed25519_copy(&tooth[0], &ed25519_base);
+	for (i = 1; i < TEETH; i++) {
+		ed25519_copy(&tooth[i], &tooth[i - 1]);
+
+		for (j = 0; j < SPACING; j++)
+			ed25519_double(&tooth[i], &tooth[i]);
+	}
+
+	/* Entry j is the sum of the teeth selected by the bits of j */
+	ed25519_copy(&p[0], &ed25519_neutral);
+	for (j = 1; j < (1 << TEETH); j++) {
+		const int low = j & -j;
+
+		for (i = 0; (1 << i) != low; i++)
+			;
+
+		ed25519_add(&p[j], &p[j ^ low], &tooth[i]);
+	}
+
+	ed25519_to_niels_batch(n, p, 1 << TEETH);
+
+	printf("static const struct ed25519_pt_niels "
+	       "base_comb[1 << BASE_COMB_TEETH] = {\n");
+
+	for (j = 0; j < (1 << TEETH); j++) {
+		printf("\t{ /* %d */\n", j);
+		print_elem("ypx", n[j].ypx, 0);
+		print_elem("ymx", n[j].ymx, 0);
+		print_elem("xy2d", n[j].xy2d, 1);
+		printf("\t}%s\n", (j == (1 << TEETH) - 1) ? "" : ",");
+	}
+
+	printf("};\n");
+	return 0;
+}
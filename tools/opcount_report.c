@@ -0,0 +1,145 @@
+/* Print the field operation profile of the high-level operations
+ *
+ * This file is in the public domain.
+ *
+ * This must be linked against a build with C25519_OPCOUNT defined
+ * ("make opcount"). The portable backends are forced, so that the
+ * profile is that of the byte-oriented point formulas: the AVX2 point
+ * code doesn't go through f25519, and wouldn't be counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include "opcount.h"
+#include "c25519.h"
+#include "edsign.h"
+#include "ecdsa.h"
+#include "sc25519.h"
+
+static const struct {
+	const char	*name;
+	size_t		offset;
+} counters[] = {
+	{"f25519_mul",		offsetof(struct opcount, f25519_mul)},
+	{"f25519_sqr",		offsetof(struct opcount, f25519_sqr)},
+	{"f25519_mul_c",	offsetof(struct opcount, f25519_mul_c)},
+	{"f25519_add",		offsetof(struct opcount, f25519_add)},
+	{"f25519_add_lazy",	offsetof(struct opcount, f25519_add_lazy)},
+	{"f25519_sub",		offsetof(struct opcount, f25519_sub)},
+	{"f25519_neg",		offsetof(struct opcount, f25519_neg)},
+	{"f25519_inv",		offsetof(struct opcount, f25519_inv)},
+	{"f25519_sqrt",		offsetof(struct opcount, f25519_sqrt)},
+	{"fprime_mul",		offsetof(struct opcount, fprime_mul)},
+	{"fprime_add",		offsetof(struct opcount, fprime_add)},
+	{"fprime_sub",		offsetof(struct opcount, fprime_sub)},
+	{"fprime_inv",		offsetof(struct opcount, fprime_inv)},
+	{"sc25519_mul",		offsetof(struct opcount, sc25519_mul)},
+	{"sc25519_add",		offsetof(struct opcount, sc25519_add)},
+	{"sc25519_inv",		offsetof(struct opcount, sc25519_inv)},
+	{"sc25519_reduce",	offsetof(struct opcount, sc25519_reduce)}
+};
+
+#define NUM_COUNTERS  (sizeof(counters) / sizeof(counters[0]))
+#define NUM_PROFILES  4
+
+static const char *const profile_names[NUM_PROFILES] = {
+	"edsign_sign", "edsign_verify", "c25519_smult", "ecdsa_verify"
+};
+
+static struct opcount profiles[NUM_PROFILES];
+
+static unsigned long get(const struct opcount *c, unsigned int i)
+{
+	return *(const unsigned long *)
+		((const char *)c + counters[i].offset);
+}
+
+static void randomize(uint8_t *x, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		x[i] = random();
+}
+
+int main(void)
+{
+	uint8_t secret[EDSIGN_SECRET_KEY_SIZE];
+	uint8_t pub[EDSIGN_PUBLIC_KEY_SIZE];
+	uint8_t sig[EDSIGN_SIGNATURE_SIZE];
+	uint8_t msg[64];
+	uint8_t e[C25519_EXPONENT_SIZE];
+	uint8_t q[F25519_SIZE];
+	uint8_t d[SC25519_SIZE];
+	uint8_t k[SC25519_SIZE];
+	uint8_t h[SC25519_SIZE];
+	uint8_t x[F25519_SIZE];
+	uint8_t y[F25519_SIZE];
+	uint8_t r[SC25519_SIZE];
+	uint8_t s[SC25519_SIZE];
+	unsigned int i, j;
+
+	if (!opcount_enabled()) {
+		fprintf(stderr, "opcount_report: not built with "
+			"C25519_OPCOUNT\n");
+		return 1;
+	}
+
+	setenv("C25519_PORTABLE", "1", 1);
+
+	randomize(secret, sizeof(secret));
+	randomize(msg, sizeof(msg));
+	randomize(e, sizeof(e));
+	randomize(d, sizeof(d));
+	randomize(k, sizeof(k));
+	c25519_prepare(e);
+	sc25519_from_bytes(d, d, sizeof(d));
+	sc25519_from_bytes(k, k, sizeof(k));
+	sc25519_from_bytes(h, msg, sizeof(h));
+	c25519_base_smult(q, e);
+	edsign_sec_to_pub(pub, secret);
+	ecdsa_pubkey(x, y, d);
+	if (!ecdsa_sign(r, s, d, h, k))
+		abort();
+
+	opcount_reset();
+	edsign_sign(sig, pub, secret, msg, sizeof(msg));
+	opcount_snapshot(&profiles[0]);
+
+	opcount_reset();
+	if (!edsign_verify(sig, pub, msg, sizeof(msg)))
+		abort();
+	opcount_snapshot(&profiles[1]);
+
+	opcount_reset();
+	c25519_smult(q, q, e);
+	opcount_snapshot(&profiles[2]);
+
+	opcount_reset();
+	if (!ecdsa_verify(x, y, h, r, s))
+		abort();
+	opcount_snapshot(&profiles[3]);
+
+	printf("%-16s", "");
+	for (j = 0; j < NUM_PROFILES; j++)
+		printf(" %14s", profile_names[j]);
+	printf("\n");
+
+	for (i = 0; i < NUM_COUNTERS; i++) {
+		unsigned long any = 0;
+
+		for (j = 0; j < NUM_PROFILES; j++)
+			any |= get(&profiles[j], i);
+
+		if (!any)
+			continue;
+
+		printf("%-16s", counters[i].name);
+		for (j = 0; j < NUM_PROFILES; j++)
+			printf(" %14lu", get(&profiles[j], i));
+		printf("\n");
+	}
+
+	return 0;
+}